@@ -0,0 +1,88 @@
+#include "Benchmarks.h"
+#include <cmath>
+#include <random>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+float randomBoxRange(int count) {
+    return 25.0f * std::cbrt(count / 10000.0f);
+}
+
+std::vector<Box> makeRandomBoxes(int count) {
+    float range = randomBoxRange(count);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> posDist(-range, range);
+    std::uniform_real_distribution<float> yDist(0.0f, 15.0f);
+    std::uniform_real_distribution<float> sizeDist(0.5f, 2.5f);
+
+    std::vector<Box> boxes;
+    boxes.reserve(count);
+    for (int i = 0; i < count; i++) {
+        boxes.emplace_back(glm::vec3(posDist(rng), yDist(rng), posDist(rng)), glm::vec3(sizeDist(rng)));
+    }
+    return boxes;
+}
+
+std::vector<Frustum> makeFrustums(int count, float range) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> posDist(-range, range);
+    std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    std::vector<Frustum> frustums(count);
+    for (Frustum& frustum : frustums) {
+        glm::vec3 eye(posDist(rng), 10.0f, posDist(rng));
+        glm::vec3 dir(dirDist(rng), dirDist(rng) * 0.3f, dirDist(rng));
+        frustum.update(projection, glm::lookAt(eye, eye + dir, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+    return frustums;
+}
+
+#ifdef __linux__
+CacheMissCounter::CacheMissCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+CacheMissCounter::~CacheMissCounter() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void CacheMissCounter::start() {
+    if (m_fd >= 0) {
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+long long CacheMissCounter::stop() {
+    long long count = -1;
+    if (m_fd >= 0) {
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+            count = -1;
+        }
+    }
+    return count;
+}
+#else
+CacheMissCounter::CacheMissCounter() : m_fd(-1) {}
+CacheMissCounter::~CacheMissCounter() {}
+void CacheMissCounter::start() {}
+long long CacheMissCounter::stop() { return -1; }
+#endif
@@ -0,0 +1,45 @@
+#include "Benchmarks.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+struct Result {
+    std::string bench;
+    std::string metric;
+    long long count;
+    double value;
+};
+
+std::string s_currentBench;
+std::vector<Result> s_results;
+
+}
+
+void beginBench(const char* name) {
+    s_currentBench = name;
+}
+
+void recordResult(const char* metric, long long count, double value) {
+    s_results.push_back({s_currentBench, metric, count, value});
+}
+
+bool writeResultsJson(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Could not write %s\n", path);
+        return false;
+    }
+
+    // One result per line, so two runs diff line by line
+    fprintf(file, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < s_results.size(); i++) {
+        const Result& result = s_results[i];
+        fprintf(file, "    {\"bench\": \"%s\", \"metric\": \"%s\", \"count\": %lld, \"value\": %.6g}%s\n",
+                result.bench.c_str(), result.metric.c_str(), result.count, result.value,
+                i + 1 < s_results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
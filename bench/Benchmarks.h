@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include "scene/Box.h"
+#include "graphics/Frustum.h"
+
+/*
+ * Engine micro benchmarks, every run* function prints its own table and records every value in
+ * it with recordResult().
+ */
+
+class BenchTimer {
+public:
+    BenchTimer() : m_start(std::chrono::high_resolution_clock::now()) {}
+
+    double elapsedMs() const {
+        auto now = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(now - m_start).count();
+    }
+
+private:
+    std::chrono::high_resolution_clock::time_point m_start;
+};
+
+// Fastest of runs calls to pass in ms, the slower ones are usually noise from the machine
+template <typename Pass>
+double bestOf(Pass pass, int runs = 5) {
+    double best = 0.0;
+    for (int run = 0; run < runs; run++) {
+        BenchTimer timer;
+        pass();
+        double ms = timer.elapsedMs();
+        if (run == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+// Hardware cache misses of this thread, Linux only. available() is false where the kernel or
+// the machine does not expose the counter, virtual machines often don't.
+class CacheMissCounter {
+public:
+    CacheMissCounter();
+    ~CacheMissCounter();
+
+    bool available() const { return m_fd >= 0; }
+    void start();
+    long long stop();
+
+private:
+    int m_fd;
+};
+
+// main calls beginBench before every run* function, results are recorded under that name.
+// count is the entity count of the row, or the thread count where rows are threads.
+void beginBench(const char* name);
+void recordResult(const char* metric, long long count, double value);
+bool writeResultsJson(const char* path);
+
+// Same distribution as createRandomObjects, with the range scaled so density stays constant
+float randomBoxRange(int count);
+std::vector<Box> makeRandomBoxes(int count);
+std::vector<Frustum> makeFrustums(int count, float range);
+
+void runOctreeMemoryBench();
+void runOctreeBuildBench();
+void runOctreeQueryBench();
+void runCullingBench();
+void runEntityLayoutBench();
+void runSceneFileBench();
+void runEcsBench();
+void runJobSystemBench();
+void runSortKeyBench();
+void runFrameBench();
@@ -0,0 +1,68 @@
+#include "Benchmarks.h"
+#include "graphics/BatchRenderer.h"
+#include "graphics/RenderPacket.h"
+#include "systems/LODSystem.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+
+// The per entity steps of Scene::buildRenderPacket and BatchRenderer::draw without the spatial
+// index, each over every box
+void runCullingBench() {
+    printf("Culling steps over every box: frustum test, LOD, instance building, batch sort\n");
+    printf("%9s | %10s | %9s | %12s | %9s | %9s\n",
+           "boxes", "frustum ms", "lod ms", "instances ms", "sort ms", "instances");
+
+    LODSystem lod;
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        float range = randomBoxRange(count);
+        glm::vec3 cameraPos(0.0f, 10.0f, range);
+        glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum;
+        frustum.update(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f), view);
+
+        std::vector<char> visible(boxes.size());
+        double frustumMs = bestOf([&]() {
+            for (size_t i = 0; i < boxes.size(); i++) {
+                visible[i] = frustum.isBoxVisible(&boxes[i]);
+            }
+        });
+
+        std::vector<LODLevel> levels(boxes.size());
+        double lodMs = bestOf([&]() {
+            for (size_t i = 0; i < boxes.size(); i++) {
+                levels[i] = lod.calculateLOD(boxes[i].position, cameraPos);
+            }
+        });
+
+        RenderPacket packet;
+        double instancesMs = bestOf([&]() {
+            packet.clear();
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (visible[i]) {
+                    packet.addInstance(boxes[i].position, boxes[i].size, levels[i]);
+                }
+            }
+        });
+
+        FrameArena arena;
+        size_t sorted = 0;
+        double sortMs = bestOf([&]() {
+            arena.reset();
+            FrameVector<uint64_t> keys{FrameAllocator<uint64_t>(arena)};
+            FrameVector<uint32_t> order{FrameAllocator<uint32_t>(arena)};
+            BatchRenderer::sortInstances(packet.instances, view, keys, order, arena);
+            sorted = keys.size();
+        });
+
+        printf("%9d | %10.3f | %9.3f | %12.3f | %9.3f | %9zu\n",
+               count, frustumMs, lodMs, instancesMs, sortMs, sorted);
+        recordResult("frustum_ms", count, frustumMs);
+        recordResult("lod_ms", count, lodMs);
+        recordResult("instances_ms", count, instancesMs);
+        recordResult("sort_ms", count, sortMs);
+        recordResult("instances", count, (double)sorted);
+    }
+    printf("(instances and sort only see the boxes the frustum kept, sort is BatchRenderer::sortInstances)\n\n");
+}
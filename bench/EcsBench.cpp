@@ -0,0 +1,79 @@
+#include "Benchmarks.h"
+#include "ecs/Components.h"
+#include "core/JobSystem.h"
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+struct Velocity {
+    glm::vec3 value;
+};
+
+}
+
+// A movement step followed by the bounds of everything, the usual per frame system work
+void runEcsBench() {
+    JobSystem jobs;
+    printf("ECS: move + bounds pass, Box vector vs archetype chunks (%d threads for parallel)\n",
+           jobs.getWorkerCount() + 1);
+    printf("%9s | %10s | %10s | %8s | %11s\n", "entities", "boxes ms", "chunks ms", "move ms", "parallel ms");
+
+    const float dt = 1.0f / 60.0f;
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        std::vector<glm::vec3> velocities(boxes.size(), glm::vec3(1.0f, 0.0f, 0.5f));
+
+        World world;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            EntityHandle entity = createBox(world, boxes[i]);
+            // Half of the boxes move, the other half stays in the Transform + Bounds archetype
+            if (i % 2 == 0) {
+                world.set(entity, Velocity{velocities[i]});
+            }
+        }
+
+        AABB total;
+        auto expand = [&total](const AABB& bounds) {
+            total.min = glm::min(total.min, bounds.min);
+            total.max = glm::max(total.max, bounds.max);
+        };
+        double boxesMs = bestOf([&]() {
+            total = AABB();
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (i % 2 == 0) {
+                    boxes[i].position += velocities[i] * dt;
+                }
+                expand(AABB::fromCenterSize(boxes[i].position, boxes[i].size));
+            }
+        });
+
+        auto move = [dt](size_t n, Transform* transforms, Velocity* velocity) {
+            for (size_t i = 0; i < n; i++) {
+                transforms[i].position += velocity[i].value * dt;
+            }
+        };
+        double chunksMs = bestOf([&]() {
+            total = AABB();
+            world.forEachChunk<Transform, Velocity>(move);
+            world.forEachChunk<Transform, Bounds>([&expand](size_t n, Transform* transforms, Bounds* bounds) {
+                for (size_t i = 0; i < n; i++) {
+                    expand(worldBounds(transforms[i], bounds[i]));
+                }
+            });
+        });
+
+        double moveMs = bestOf([&]() { world.forEachChunk<Transform, Velocity>(move); });
+        double parallelMs = bestOf([&]() { world.forEachChunkParallel<Transform, Velocity>(jobs, move); });
+        printf("%9d | %10.3f | %10.3f | %8.3f | %11.3f\n", count, boxesMs, chunksMs, moveMs, parallelMs);
+        recordResult("boxes_ms", count, boxesMs);
+        recordResult("chunks_ms", count, chunksMs);
+        recordResult("move_ms", count, moveMs);
+        recordResult("parallel_ms", count, parallelMs);
+        if (total.min.x > total.max.x) {
+            printf("empty\n");
+        }
+    }
+    printf("(move and parallel run the move step alone, serial and over all threads)\n\n");
+}
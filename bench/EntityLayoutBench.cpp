@@ -0,0 +1,106 @@
+#include "Benchmarks.h"
+#include "scene/EntityStorage.h"
+#include "scene/Octree.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <cmath>
+
+namespace {
+
+struct FrameResult {
+    double ms = 0.0;
+    long long misses = -1;
+};
+
+// The work renderScene does per visible entity: row lookup, LOD distance and the instance matrix
+FrameResult timeRenderPass(const Octree<EntityHandle, EntityBounds>& tree, const EntityStorage& storage,
+                           const std::vector<Frustum>& frustums, CacheMissCounter& counter) {
+    const std::vector<glm::vec3>& positions = storage.getPositions();
+    const std::vector<glm::vec3>& sizes = storage.getSizes();
+    std::vector<glm::mat4> instances;
+    instances.reserve(storage.size());
+    glm::vec3 cameraPos(0.0f, 10.0f, 0.0f);
+    float far = 0.0f;
+
+    FrameResult best;
+    for (int run = 0; run < 3; run++) {
+        counter.start();
+        BenchTimer timer;
+        for (const Frustum& frustum : frustums) {
+            instances.clear();
+            tree.forEachInFrustum(frustum, [&](EntityHandle entity) {
+                int row = storage.indexOf(entity);
+                if (glm::distance(positions[row], cameraPos) > 150.0f) {
+                    far += 1.0f;
+                    return;
+                }
+                instances.push_back(glm::scale(glm::translate(glm::mat4(1.0f), positions[row]), sizes[row]));
+            });
+        }
+        double ms = timer.elapsedMs() / frustums.size();
+        long long misses = counter.stop();
+
+        if (run == 0 || ms < best.ms) {
+            best.ms = ms;
+            best.misses = misses;
+        }
+    }
+
+    // Keeps the compiler from dropping the loop
+    if (far < 0.0f) {
+        printf("%f\n", far);
+    }
+    return best;
+}
+
+}
+
+void runEntityLayoutBench() {
+    printf("Entity layout: creation order vs Morton order, octree frustum pass per frame\n");
+    printf("%9s | %11s | %11s | %7s | %9s | %13s | %13s\n",
+           "entities", "created ms", "morton ms", "speedup", "sort ms", "misses before", "misses after");
+
+    CacheMissCounter counter;
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        EntityStorage storage;
+        storage.reserve(boxes.size());
+        std::vector<EntityHandle> handles;
+        handles.reserve(boxes.size());
+        for (const Box& box : boxes) {
+            handles.push_back(storage.create(box.position, box.size));
+        }
+
+        Octree<EntityHandle, EntityBounds> tree(glm::vec3(0.0f), 100.0f, EntityBounds(&storage));
+        tree.insert(handles);
+        std::vector<Frustum> frustums = makeFrustums(64, randomBoxRange(count));
+
+        FrameResult before = timeRenderPass(tree, storage, frustums, counter);
+        BenchTimer sortTimer;
+        storage.sortSpatially();
+        double sortMs = sortTimer.elapsedMs();
+        FrameResult after = timeRenderPass(tree, storage, frustums, counter);
+
+        char missesBefore[32] = "n/a";
+        char missesAfter[32] = "n/a";
+        if (counter.available()) {
+            snprintf(missesBefore, sizeof(missesBefore), "%lld", before.misses);
+            snprintf(missesAfter, sizeof(missesAfter), "%lld", after.misses);
+        }
+
+        printf("%9d | %11.3f | %11.3f | %6.2fx | %9.2f | %13s | %13s\n",
+               count, before.ms, after.ms, before.ms / after.ms, sortMs, missesBefore, missesAfter);
+        recordResult("created_order_ms", count, before.ms);
+        recordResult("morton_order_ms", count, after.ms);
+        recordResult("sort_ms", count, sortMs);
+        if (counter.available()) {
+            recordResult("misses_before", count, (double)before.misses);
+            recordResult("misses_after", count, (double)after.misses);
+        }
+    }
+    if (!counter.available()) {
+        printf("(hardware cache miss counter not available here)\n");
+    }
+    printf("\n");
+}
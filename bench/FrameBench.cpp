@@ -0,0 +1,87 @@
+#include "Benchmarks.h"
+#include "core/Application.h"
+#include "graphics/NullBackend.h"
+#include "SceneGenerators.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+const int kWarmupFrames = 10;
+const int kTimedFrames = 60;
+
+enum class GeneratedScene {
+    Random,  // createRandomObjects, moving boxes
+    Grid     // createTerrainGrid, static blocks baked into chunks
+};
+
+void benchBackend(RenderBackendType type, GeneratedScene generated, int count) {
+    const char* backendName = RenderBackend::getTypeName(type);
+    const char* sceneName = generated == GeneratedScene::Random ? "random" : "grid";
+
+    Application app(1280, 720, "engine_bench", type);
+    if (!app.isInitialized()) {
+        printf("%9s | %6s | %9d | unavailable\n", backendName, sceneName, count);
+        return;
+    }
+
+    // Never updated without a window, so the camera stays put
+    InputManager input;
+    for (const char* action : {"forward", "backward", "left", "right", "up", "down"}) {
+        input.bindKey(action, GLFW_KEY_UNKNOWN);
+    }
+    FlyCamera camera(&input);
+    app.setCamera(&camera);
+
+    Scene* scene = app.createScene("bench");
+    if (generated == GeneratedScene::Random) {
+        float range = randomBoxRange(count);
+        createRandomObjects(scene, count, -range, range);
+        camera.setPosition(glm::vec3(0.0f, 10.0f, range * 1.5f));
+    } else {
+        // (size * 2 + 1)^2 blocks, 2 units apart
+        int size = (int)std::lround((std::sqrt((double)count) - 1.0) / 2.0);
+        createTerrainGrid(scene, size, 2.0f);
+        camera.setPosition(glm::vec3(0.0f, 10.0f, size * 2.0f));
+    }
+
+    // The first frames build the spatial index and bake the static chunks
+    app.setFrameLimit(kWarmupFrames);
+    app.run();
+
+    app.setFrameLimit(kTimedFrames);
+    BenchTimer timer;
+    app.run();
+    double msPerFrame = timer.elapsedMs() / kTimedFrames;
+    const CullingStats& stats = scene->getCullingStats();
+
+    printf("%9s | %6s | %9d | %8.3f | %8d", backendName, sceneName, stats.totalEntities, msPerFrame, stats.rendered);
+    std::string prefix = std::string(sceneName) + "_" + backendName;
+    recordResult((prefix + "_ms_per_frame").c_str(), count, msPerFrame);
+    recordResult((prefix + "_rendered").c_str(), count, stats.rendered);
+    if (type == RenderBackendType::Null) {
+        const NullBackend* backend = static_cast<const NullBackend*>(app.getBackend());
+        uint64_t instances = backend->getLastFrame().instances;
+        printf(" | %9llu", (unsigned long long)instances);
+        recordResult((prefix + "_instances").c_str(), count, (double)instances);
+    }
+    printf("\n");
+}
+
+}
+
+void runFrameBench() {
+    printf("Whole frames headless on generated scenes, render thread on\n");
+    printf("%9s | %6s | %9s | %8s | %8s | %9s\n", "backend", "scene", "entities", "ms/frame", "rendered", "instances");
+
+    const int counts[] = {10000, 100000, 1000000};
+    for (GeneratedScene generated : {GeneratedScene::Random, GeneratedScene::Grid}) {
+        for (int count : counts) {
+            benchBackend(RenderBackendType::Null, generated, count);
+        }
+        // Software GL takes most of a second per frame at 100k
+        benchBackend(RenderBackendType::Offscreen, generated, counts[0]);
+    }
+    printf("(null only counts the draws, offscreen draws them with GL and waits for each frame)\n\n");
+}
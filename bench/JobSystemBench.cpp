@@ -0,0 +1,113 @@
+#include "Benchmarks.h"
+#include "core/JobSystem.h"
+#include "scene/Octree.h"
+#include <cstdio>
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+const int kCullFrustums = 8;
+const size_t kCullGrain = 16384;
+const int kTrees = 8;
+
+// The scene's culling path without a spatial index, one job per range of boxes
+double timeCulling(JobSystem& jobs, const std::vector<Box>& boxes, const std::vector<Frustum>& frustums,
+                   size_t& visible) {
+    size_t ranges = (boxes.size() + kCullGrain - 1) / kCullGrain;
+    std::vector<size_t> counts(ranges);
+
+    BenchTimer timer;
+    for (const Frustum& frustum : frustums) {
+        jobs.parallelFor(boxes.size(), kCullGrain, [&](size_t begin, size_t end) {
+            size_t count = 0;
+            for (size_t i = begin; i < end; i++) {
+                count += frustum.isAABBVisible(AABB::fromCenterSize(boxes[i].position, boxes[i].size)) ? 1 : 0;
+            }
+            counts[begin / kCullGrain] += count;
+        });
+    }
+    double ms = timer.elapsedMs();
+
+    visible = 0;
+    for (size_t count : counts) {
+        visible += count;
+    }
+    return ms;
+}
+
+// Independent trees built side by side, one job each
+double timeTreeBuilds(JobSystem& jobs, std::vector<std::vector<Box*>>& parts, int& nodes) {
+    std::vector<BoxOctree*> trees(parts.size());
+    JobCounter built;
+
+    BenchTimer timer;
+    for (size_t i = 0; i < parts.size(); i++) {
+        jobs.run([&trees, &parts, i]() {
+            trees[i] = new BoxOctree();
+            trees[i]->insert(parts[i]);
+        }, &built);
+    }
+    jobs.wait(built);
+    double ms = timer.elapsedMs();
+
+    nodes = 0;
+    for (BoxOctree* tree : trees) {
+        nodes += tree->getNodeCount();
+        delete tree;
+    }
+    return ms;
+}
+
+}
+
+void runJobSystemBench() {
+    int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+    printf("Job system: 1M box frustum culls and %d octree builds from 1 to %d threads\n", kTrees, cores);
+    printf("%7s | %9s | %7s | %9s | %7s\n", "threads", "cull ms", "scaling", "build ms", "scaling");
+
+    std::vector<Box> boxes = makeRandomBoxes(1000000);
+    std::vector<Frustum> frustums = makeFrustums(kCullFrustums, 250.0f);
+    std::vector<std::vector<Box*>> parts(kTrees);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        parts[i % kTrees].push_back(&boxes[i]);
+    }
+
+    // Powers of two and the core count itself
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    double cullBase = 0.0;
+    double buildBase = 0.0;
+    for (int threads : threadCounts) {
+        // The calling thread helps while waiting, so it counts as one of the threads
+        JobSystem jobs(threads - 1);
+
+        double cullMs = 0.0;
+        double buildMs = 0.0;
+        size_t visible = 0;
+        int nodes = 0;
+        for (int run = 0; run < 3; run++) {
+            double cull = timeCulling(jobs, boxes, frustums, visible);
+            double build = timeTreeBuilds(jobs, parts, nodes);
+            cullMs = run == 0 ? cull : std::min(cullMs, cull);
+            buildMs = run == 0 ? build : std::min(buildMs, build);
+        }
+        if (threads == 1) {
+            cullBase = cullMs;
+            buildBase = buildMs;
+        }
+
+        printf("%7d | %9.2f | %6.2fx | %9.2f | %6.2fx\n",
+               threads, cullMs, cullBase / cullMs, buildMs, buildBase / buildMs);
+        recordResult("cull_ms", threads, cullMs);
+        recordResult("build_ms", threads, buildMs);
+        if (visible == 0 && nodes == 0) {
+            printf("empty\n");
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,42 @@
+#include "Benchmarks.h"
+#include "scene/Octree.h"
+#include <cstdio>
+
+void runOctreeBuildBench() {
+    printf("Octree build: one insert per box vs bulk insert, and rebuilding the bulk tree\n");
+    printf("%9s | %11s | %11s | %7s | %11s | %9s\n", "boxes", "insert ms", "bulk ms", "speedup", "rebuild ms", "nodes");
+
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        std::vector<Box*> pointers;
+        pointers.reserve(boxes.size());
+        for (Box& box : boxes) {
+            pointers.push_back(&box);
+        }
+
+        BoxOctree single;
+        BenchTimer singleTimer;
+        for (Box* box : pointers) {
+            single.insert(box);
+        }
+        double singleMs = singleTimer.elapsedMs();
+
+        BoxOctree bulk;
+        BenchTimer bulkTimer;
+        bulk.insert(pointers);
+        double bulkMs = bulkTimer.elapsedMs();
+
+        BenchTimer rebuildTimer;
+        bulk.rebuild(pointers);
+        double rebuildMs = rebuildTimer.elapsedMs();
+
+        printf("%9d | %11.2f | %11.2f | %6.1fx | %11.2f | %9d\n",
+               count, singleMs, bulkMs, singleMs / bulkMs, rebuildMs, bulk.getNodeCount());
+        recordResult("insert_ms", count, singleMs);
+        recordResult("bulk_insert_ms", count, bulkMs);
+        recordResult("rebuild_ms", count, rebuildMs);
+        recordResult("nodes", count, bulk.getNodeCount());
+    }
+    printf("\n");
+}
@@ -0,0 +1,61 @@
+#include "Benchmarks.h"
+#include "scene/Octree.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+
+namespace {
+    double timeFrustumQueries(const BoxOctree& octree, const std::vector<Frustum>& frustums, size_t& visible) {
+        std::vector<Box*> result;
+        visible = 0;
+
+        BenchTimer timer;
+        for (const Frustum& frustum : frustums) {
+            octree.queryFrustum(frustum, result);
+            visible += result.size();
+        }
+        return timer.elapsedMs() / frustums.size();
+    }
+}
+
+void runOctreeMemoryBench() {
+    printf("Octree memory: pointer tree vs compressed (quantized) mode\n");
+    printf("%9s | %-7s | %9s | %11s | %9s\n",
+           "boxes", "mode", "index B/o", "frustum ms", "visible");
+
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        std::vector<Frustum> frustums = makeFrustums(16, randomBoxRange(count));
+
+        BoxOctree octree;
+        for (Box& box : boxes) {
+            octree.insert(&box);
+        }
+
+        struct Mode { const char* name; const char* key; bool compressed; OctreeBoundsPrecision precision; };
+        const Mode modes[] = {
+            {"tree", "tree", false, OctreeBoundsPrecision::Bits16},
+            {"16 bit", "bits16", true, OctreeBoundsPrecision::Bits16},
+            {"8 bit", "bits8", true, OctreeBoundsPrecision::Bits8},
+        };
+
+        for (const Mode& mode : modes) {
+            octree.setCompressed(mode.compressed, mode.precision);
+            octree.compact();
+
+            OctreeMemoryStats stats = octree.getMemoryStats();
+            float indexBytes = mode.compressed ? stats.compactBytesPerObject() : stats.treeBytesPerObject();
+
+            size_t visible = 0;
+            double ms = timeFrustumQueries(octree, frustums, visible);
+
+            printf("%9d | %-7s | %9.1f | %11.3f | %9zu\n",
+                   count, mode.name, indexBytes, ms, visible / frustums.size());
+            recordResult((std::string(mode.key) + "_bytes_per_object").c_str(), count, indexBytes);
+            recordResult((std::string(mode.key) + "_frustum_ms").c_str(), count, ms);
+        }
+    }
+    printf("\n");
+}
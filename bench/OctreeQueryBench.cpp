@@ -0,0 +1,98 @@
+#include "Benchmarks.h"
+#include "scene/Octree.h"
+#include <cstdio>
+#include <random>
+
+namespace {
+
+const int kFrustums = 64;
+const int kQueries = 1000;
+
+struct Probe {
+    glm::vec3 point;
+    glm::vec3 direction;
+};
+
+// Points inside the box volume and directions mostly level, like a player looking around
+std::vector<Probe> makeProbes(float range) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> posDist(-range, range);
+    std::uniform_real_distribution<float> yDist(0.0f, 15.0f);
+    std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
+
+    std::vector<Probe> probes(kQueries);
+    for (Probe& probe : probes) {
+        probe.point = glm::vec3(posDist(rng), yDist(rng), posDist(rng));
+        probe.direction = glm::normalize(glm::vec3(dirDist(rng), dirDist(rng) * 0.3f, dirDist(rng) + 0.01f));
+    }
+    return probes;
+}
+
+}
+
+void runOctreeQueryBench() {
+    printf("Octree queries: %d frustums, %d AABB / range / raycast queries of 10 units\n", kFrustums, kQueries);
+    printf("%9s | %10s | %8s | %8s | %10s | %8s\n", "boxes", "frustum ms", "aabb us", "range us", "raycast us", "ray hits");
+
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        std::vector<Box*> pointers;
+        pointers.reserve(boxes.size());
+        for (Box& box : boxes) {
+            pointers.push_back(&box);
+        }
+        BoxOctree octree;
+        octree.insert(pointers);
+
+        float range = randomBoxRange(count);
+        std::vector<Frustum> frustums = makeFrustums(kFrustums, range);
+        std::vector<Probe> probes = makeProbes(range);
+        std::vector<Box*> result;
+        size_t found = 0;
+
+        BenchTimer frustumTimer;
+        for (const Frustum& frustum : frustums) {
+            octree.queryFrustum(frustum, result);
+            found += result.size();
+        }
+        double frustumMs = frustumTimer.elapsedMs() / kFrustums;
+
+        const glm::vec3 half(5.0f);
+        BenchTimer aabbTimer;
+        for (const Probe& probe : probes) {
+            octree.queryAABB(probe.point - half, probe.point + half, result);
+            found += result.size();
+        }
+        double aabbUs = aabbTimer.elapsedMs() * 1000.0 / kQueries;
+
+        BenchTimer rangeTimer;
+        for (const Probe& probe : probes) {
+            octree.queryRange(probe.point, 10.0f, result);
+            found += result.size();
+        }
+        double rangeUs = rangeTimer.elapsedMs() * 1000.0 / kQueries;
+
+        int hits = 0;
+        BenchTimer rayTimer;
+        for (const Probe& probe : probes) {
+            Box* hit = nullptr;
+            if (octree.raycast(probe.point, probe.direction, 10.0f, &hit)) {
+                hits++;
+            }
+        }
+        double rayUs = rayTimer.elapsedMs() * 1000.0 / kQueries;
+
+        printf("%9d | %10.3f | %8.2f | %8.2f | %10.2f | %8d\n", count, frustumMs, aabbUs, rangeUs, rayUs, hits);
+        recordResult("frustum_ms", count, frustumMs);
+        recordResult("aabb_us", count, aabbUs);
+        recordResult("range_us", count, rangeUs);
+        recordResult("raycast_us", count, rayUs);
+
+        // Keeps the compiler from dropping the queries
+        if (found == 0) {
+            printf("empty\n");
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,95 @@
+#include "Benchmarks.h"
+#include "scene/EntityStorage.h"
+#include "scene/Octree.h"
+#include "scene/SceneFile.h"
+#include <cstdio>
+
+// The entity and octree half of Scene::saveToFile / loadFromFile, the scene itself needs a GL context
+void runSceneFileBench() {
+    printf("Scene file: creating entities and building the compressed octree vs loading them from a file\n");
+    printf("%9s | %11s | %11s | %11s | %7s | %9s\n", "entities", "build ms", "save ms", "load ms", "speedup", "file MB");
+
+    const char* path = "bench_scene.tmp";
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+
+        BenchTimer buildTimer;
+        EntityStorage storage;
+        storage.reserve(boxes.size());
+        std::vector<EntityHandle> handles;
+        handles.reserve(boxes.size());
+        for (const Box& box : boxes) {
+            handles.push_back(storage.create(box.position, box.size));
+        }
+        Octree<EntityHandle, EntityBounds> tree(glm::vec3(0.0f), 100.0f, EntityBounds(&storage));
+        tree.setCompressed(true);
+        tree.insert(handles);
+        tree.compact();
+        double buildMs = buildTimer.elapsedMs();
+
+        BenchTimer saveTimer;
+        std::vector<uint32_t> generations(storage.slotCount());
+        for (size_t i = 0; i < generations.size(); i++) {
+            generations[i] = storage.generationAt(i);
+        }
+        SceneFileWriter writer;
+        writer.addSection(SceneSection::Positions, storage.getPositions());
+        writer.addSection(SceneSection::Sizes, storage.getSizes());
+        writer.addSection(SceneSection::StaticFlags, storage.getStaticFlags());
+        writer.addSection(SceneSection::RowSlots, storage.getRowSlots());
+        writer.addSection(SceneSection::Generations, generations);
+        writer.addSection(SceneSection::DynamicNodes, tree.getPackedNodes());
+        writer.addSection(SceneSection::DynamicObjects, tree.getPackedObjects());
+        writer.addSection(SceneSection::DynamicBounds, tree.getPackedBounds16());
+        SceneFileHeader header = {};
+        header.dynamicPrecision = 16;
+        if (!writer.write(path, header)) {
+            return;
+        }
+        double saveMs = saveTimer.elapsedMs();
+
+        BenchTimer loadTimer;
+        SceneFileReader reader;
+        EntityStorage loaded;
+        Octree<EntityHandle, EntityBounds> loadedTree(glm::vec3(0.0f), 100.0f, EntityBounds(&loaded));
+        size_t rows, sizeRows, flagRows, slotRows, slots, nodes, objects, bounds;
+        bool ok = reader.open(path);
+        if (ok) {
+            const glm::vec3* positions = reader.section<glm::vec3>(SceneSection::Positions, rows);
+            const glm::vec3* sizes = reader.section<glm::vec3>(SceneSection::Sizes, sizeRows);
+            const uint8_t* flags = reader.section<uint8_t>(SceneSection::StaticFlags, flagRows);
+            const uint32_t* rowSlots = reader.section<uint32_t>(SceneSection::RowSlots, slotRows);
+            const uint32_t* gens = reader.section<uint32_t>(SceneSection::Generations, slots);
+            const PackedOctreeNode* packedNodes = reader.section<PackedOctreeNode>(SceneSection::DynamicNodes, nodes);
+            const EntityHandle* packedObjects = reader.section<EntityHandle>(SceneSection::DynamicObjects, objects);
+            const QuantizedBounds16* packedBounds = reader.section<QuantizedBounds16>(SceneSection::DynamicBounds, bounds);
+            ok = positions && sizes && flags && rowSlots && gens && packedNodes && packedObjects && packedBounds &&
+                 loaded.load(positions, sizes, flags, rowSlots, rows, gens, slots) &&
+                 loadedTree.loadCompact(packedNodes, nodes, packedObjects, objects, packedBounds);
+            // Scene::loadFromFile checks every indexed handle too
+            for (size_t i = 0; ok && i < objects; i++) {
+                ok = loaded.isAlive(packedObjects[i]);
+            }
+        }
+        double loadMs = loadTimer.elapsedMs();
+        reader.close();
+        std::remove(path);
+
+        if (!ok || loadedTree.getObjectCount() != count) {
+            printf("%9d | loading failed\n", count);
+            continue;
+        }
+
+        size_t bytes = storage.size() * (2 * sizeof(glm::vec3) + sizeof(uint8_t) + 2 * sizeof(uint32_t)) +
+                       tree.getPackedNodes().size() * sizeof(PackedOctreeNode) +
+                       tree.getPackedObjects().size() * (sizeof(EntityHandle) + sizeof(QuantizedBounds16));
+        printf("%9d | %11.2f | %11.2f | %11.2f | %6.1fx | %9.1f\n",
+               count, buildMs, saveMs, loadMs, buildMs / loadMs, bytes / (1024.0 * 1024.0));
+        recordResult("build_ms", count, buildMs);
+        recordResult("save_ms", count, saveMs);
+        recordResult("load_ms", count, loadMs);
+        recordResult("file_bytes", count, (double)bytes);
+    }
+    printf("\n");
+}
@@ -0,0 +1,60 @@
+#include "Benchmarks.h"
+#include "graphics/BatchRenderer.h"
+#include "core/RadixSort.h"
+#include <algorithm>
+#include <cstdio>
+
+void runSortKeyBench() {
+    printf("Instance sort keys: LOD + depth from the origin, std::sort vs radixSort\n");
+    printf("%9s | %12s | %12s\n", "instances", "std::sort ms", "radix ms");
+
+    LODSystem lod;
+    const int counts[] = {10000, 100000, 1000000};
+    for (int count : counts) {
+        std::vector<Box> boxes = makeRandomBoxes(count);
+        std::vector<uint64_t> keys(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++) {
+            glm::vec3 position = boxes[i].position;
+            LODLevel level = lod.calculateLOD(position, glm::vec3(0.0f));
+            float depth = std::sqrt(glm::dot(position, position));
+            keys[i] = BatchRenderer::makeSortKey(level == LODLevel::CULLED ? LODLevel::LOW : level, 0, 0, depth);
+        }
+
+        struct Entry {
+            uint64_t key;
+            uint32_t index;
+        };
+        std::vector<Entry> entries(keys.size());
+        double stdMs = bestOf([&]() {
+            for (size_t i = 0; i < keys.size(); i++) {
+                entries[i] = {keys[i], (uint32_t)i};
+            }
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                return a.key != b.key ? a.key < b.key : a.index < b.index;
+            });
+        });
+
+        FrameArena arena;
+        std::vector<uint64_t> sorted(keys.size());
+        std::vector<uint32_t> order(keys.size());
+        double radixMs = bestOf([&]() {
+            arena.reset();
+            sorted = keys;
+            for (size_t i = 0; i < order.size(); i++) {
+                order[i] = (uint32_t)i;
+            }
+            radixSort(sorted.data(), order.data(), sorted.size(), arena);
+        });
+
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (sorted[i] != entries[i].key || order[i] != entries[i].index) {
+                printf("mismatch at %zu\n", i);
+                break;
+            }
+        }
+        printf("%9d | %12.3f | %12.3f\n", count, stdMs, radixMs);
+        recordResult("std_sort_ms", count, stdMs);
+        recordResult("radix_ms", count, radixMs);
+    }
+    printf("(both include filling the index list, radix skips the mesh and material bytes)\n\n");
+}
@@ -0,0 +1,79 @@
+#include "Benchmarks.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Bench {
+    const char* name;
+    void (*run)();
+};
+
+const Bench kBenches[] = {
+    {"octree_memory", runOctreeMemoryBench},
+    {"octree_build", runOctreeBuildBench},
+    {"octree_query", runOctreeQueryBench},
+    {"culling", runCullingBench},
+    {"entity_layout", runEntityLayoutBench},
+    {"scene_file", runSceneFileBench},
+    {"ecs", runEcsBench},
+    {"job_system", runJobSystemBench},
+    {"sort_keys", runSortKeyBench},
+    {"frame", runFrameBench},
+};
+
+void printUsage() {
+    printf("usage: engine_bench [--json file] [bench...]\n\nbenches:");
+    for (const Bench& bench : kBenches) {
+        printf(" %s", bench.name);
+    }
+    printf("\n");
+}
+
+}
+
+// engine_bench [--json file] [bench...], runs every bench when none are named
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+    std::vector<const char*> selected;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            selected.push_back(argv[i]);
+        }
+    }
+    for (const char* name : selected) {
+        bool known = false;
+        for (const Bench& bench : kBenches) {
+            known = known || strcmp(bench.name, name) == 0;
+        }
+        if (!known) {
+            printf("unknown bench '%s'\n", name);
+            printUsage();
+            return 1;
+        }
+    }
+
+    printf("Engine benchmarks\n\n");
+
+    for (const Bench& bench : kBenches) {
+        bool run = selected.empty();
+        for (const char* name : selected) {
+            run = run || strcmp(bench.name, name) == 0;
+        }
+        if (run) {
+            beginBench(bench.name);
+            bench.run();
+        }
+    }
+
+    if (jsonPath && !writeResultsJson(jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
@@ -3,7 +3,7 @@ message(STATUS "Configuring for Linux")
 # -------------------------------------------------
 # OpenGL
 # -------------------------------------------------
-find_package(OpenGL REQUIRED)
+find_package(OpenGL REQUIRED OPTIONAL_COMPONENTS EGL)
 
 # -------------------------------------------------
 # pkg-config
@@ -22,6 +22,14 @@ set(PLATFORM_LIBS
         ${GLEW_LIBRARIES}
 )
 
+# The offscreen render backend needs EGL
+if (OpenGL_EGL_FOUND)
+    list(APPEND PLATFORM_LIBS OpenGL::EGL)
+    set(PLATFORM_DEFINITIONS ENGINE_HAS_EGL)
+else()
+    message(STATUS "EGL not found, the offscreen render backend is disabled")
+endif()
+
 # -------------------------------------------------
 # Include directories
 # -------------------------------------------------
@@ -0,0 +1,58 @@
+#include "CameraPath.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+
+namespace {
+
+const char* kHeader = "camera path 1";
+
+}
+
+bool CameraPath::saveToFile(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    file << kHeader << '\n' << std::setprecision(std::numeric_limits<float>::max_digits10);
+    for (const CameraPose& pose : m_poses) {
+        file << pose.position.x << ' ' << pose.position.y << ' ' << pose.position.z << ' '
+             << pose.yaw << ' ' << pose.pitch << '\n';
+    }
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CameraPath::loadFromFile(const std::string& path) {
+    m_poses.clear();
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::string header;
+    std::getline(file, header);
+    if (header != kHeader) {
+        std::cerr << path << " is not a camera path" << std::endl;
+        return false;
+    }
+
+    CameraPose pose;
+    while (file >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch) {
+        m_poses.push_back(pose);
+    }
+    if (!file.eof()) {
+        std::cerr << path << " is broken after " << m_poses.size() << " poses" << std::endl;
+        m_poses.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+struct CameraPose {
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+// One camera pose per frame, recorded from a flight and replayed to get the same frames again.
+// Saved as text, a version line and then one pose per line, written with enough digits that
+// loading gives back the exact floats.
+class CameraPath {
+public:
+    void add(const CameraPose& pose) { m_poses.push_back(pose); }
+    void clear() { m_poses.clear(); }
+    void reserve(size_t frames) { m_poses.reserve(frames); }
+
+    size_t size() const { return m_poses.size(); }
+    bool empty() const { return m_poses.empty(); }
+    const CameraPose& operator[](size_t frame) const { return m_poses[frame]; }
+
+    bool saveToFile(const std::string& path) const;
+    // Leaves the path empty and prints why when the file is missing or broken
+    bool loadFromFile(const std::string& path);
+
+private:
+    std::vector<CameraPose> m_poses;
+};
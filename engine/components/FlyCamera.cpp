@@ -10,13 +10,21 @@ FlyCamera::FlyCamera(InputManager* input)
       m_worldUp(0.0f, 1.0f, 0.0f),
       m_yaw(-90.0f),
       m_pitch(0.0f),
-      m_speed(0.05f),
-      m_sensitivity(0.1f)
+      m_speed(3.0f),
+      m_sensitivity(0.1f),
+      m_previousPosition(m_position),
+      m_previousYaw(m_yaw),
+      m_previousPitch(m_pitch)
 {
     updateCameraVectors();
 }
 
-void FlyCamera::update() {
+void FlyCamera::update(float dt) {
+    m_previousPosition = m_position;
+    m_previousYaw = m_yaw;
+    m_previousPitch = m_pitch;
+
+    // The mouse moved this far since the last update, however many frames that was
     double deltaX, deltaY;
     m_input->getMouseDelta(deltaX, deltaY);
 
@@ -28,44 +36,64 @@ void FlyCamera::update() {
 
     updateCameraVectors();
 
-    bool moved = false;
+    float distance = m_speed * dt;
     if (m_input->isActionPressed("forward")) {
-        m_position += m_speed * m_front;
-        moved = true;
+        m_position += distance * m_front;
     }
     if (m_input->isActionPressed("backward")) {
-        m_position -= m_speed * m_front;
-        moved = true;
+        m_position -= distance * m_front;
     }
     if (m_input->isActionPressed("left")) {
-        m_position -= m_right * m_speed;
-        moved = true;
+        m_position -= m_right * distance;
     }
     if (m_input->isActionPressed("right")) {
-        m_position += m_right * m_speed;
-        moved = true;
+        m_position += m_right * distance;
     }
     if (m_input->isActionPressed("up")) {
-        m_position += m_up * m_speed;
-        moved = true;
+        m_position += m_up * distance;
     }
     if (m_input->isActionPressed("down")) {
-        m_position -= m_up * m_speed;
-        moved = true;
+        m_position -= m_up * distance;
     }
 }
 
-void FlyCamera::updateCameraVectors() {
+glm::vec3 FlyCamera::frontFrom(float yaw, float pitch) {
     glm::vec3 front;
-    front.x = cos(glm::radians(m_yaw)) * cos(glm::radians(m_pitch));
-    front.y = sin(glm::radians(m_pitch));
-    front.z = sin(glm::radians(m_yaw)) * cos(glm::radians(m_pitch));
-    m_front = glm::normalize(front);
+    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    front.y = sin(glm::radians(pitch));
+    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    return glm::normalize(front);
+}
+
+void FlyCamera::setPose(const glm::vec3& position, float yaw, float pitch) {
+    m_position = position;
+    m_yaw = yaw;
+    m_pitch = pitch;
+    m_previousPosition = position;
+    m_previousYaw = yaw;
+    m_previousPitch = pitch;
+    updateCameraVectors();
+}
 
+void FlyCamera::updateCameraVectors() {
+    m_front = frontFrom(m_yaw, m_pitch);
     m_right = glm::normalize(glm::cross(m_front, m_worldUp));
     m_up = glm::normalize(glm::cross(m_right, m_front));
 }
 
 glm::mat4 FlyCamera::getViewMatrix() const {
     return glm::lookAt(m_position, m_position + m_front, m_up);
-}
\ No newline at end of file
+}
+
+glm::vec3 FlyCamera::getInterpolatedPosition(float alpha) const {
+    return glm::mix(m_previousPosition, m_position, alpha);
+}
+
+glm::mat4 FlyCamera::getInterpolatedViewMatrix(float alpha) const {
+    // Yaw and pitch are never wrapped, so a plain lerp takes the short way round
+    glm::vec3 position = getInterpolatedPosition(alpha);
+    glm::vec3 front = frontFrom(m_previousYaw + (m_yaw - m_previousYaw) * alpha,
+                                m_previousPitch + (m_pitch - m_previousPitch) * alpha);
+    glm::vec3 right = glm::normalize(glm::cross(front, m_worldUp));
+    return glm::lookAt(position, position + front, glm::normalize(glm::cross(right, front)));
+}
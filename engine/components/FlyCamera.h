@@ -7,15 +7,23 @@
 class FlyCamera {
 public:
     FlyCamera(InputManager* input);
-    void update();
+    // Moves by speed * dt, dt in seconds. Called once per fixed step by Application.
+    void update(float dt);
     glm::mat4 getViewMatrix() const;
+    // Between the last two updates, alpha 0 is the one before the last and 1 the last
+    glm::mat4 getInterpolatedViewMatrix(float alpha) const;
+    glm::vec3 getInterpolatedPosition(float alpha) const;
 
     glm::vec3 getPosition() const { return m_position; }
     glm::vec3 getFront() const { return m_front; }
     glm::vec3 getUp() const { return m_up; }
     glm::vec3 getRight() const { return m_right; }
 
-    void setPosition(const glm::vec3& pos) { m_position = pos; }
+    // Jumps there, no interpolation from the old position
+    void setPosition(const glm::vec3& pos) { m_position = pos; m_previousPosition = pos; }
+    // Same for the whole pose, used to replay a recorded path
+    void setPose(const glm::vec3& position, float yaw, float pitch);
+    // Units per second
     void setSpeed(float speed) { m_speed = speed; }
     void setSensitivity(float sensitivity) { m_sensitivity = sensitivity; }
 
@@ -35,5 +43,10 @@ private:
     float m_speed;
     float m_sensitivity;
 
+    glm::vec3 m_previousPosition;
+    float m_previousYaw;
+    float m_previousPitch;
+
     void updateCameraVectors();
+    static glm::vec3 frontFrom(float yaw, float pitch);
 };
\ No newline at end of file
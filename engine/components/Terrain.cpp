@@ -0,0 +1,287 @@
+#include "Terrain.h"
+#include "../graphics/MeshCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kGridVertices = (Terrain::kChunkCells + 1) * (Terrain::kChunkCells + 1);
+const int kFloatsPerVertex = 6;
+const int kMaxLevels = 10;
+
+}
+
+Terrain::Terrain(int cellsPerSide, float spacing, const glm::vec3& origin)
+    : m_cells(kChunkCells), m_levels(1), m_spacing(spacing > 0.0f ? spacing : 1.0f), m_origin(origin),
+      m_lodRange(kChunkCells * m_spacing), m_indexMesh(0), m_indexCount(0) {
+    while (m_cells < cellsPerSide && m_levels < kMaxLevels) {
+        m_cells *= 2;
+        m_levels++;
+    }
+
+    int samples = m_cells + 1;
+    m_heights.assign((size_t)samples * samples, 0.0f);
+
+    m_nodes.reserve(((size_t)1 << (2 * m_levels)) / 3 + 1);
+    buildNode(0, 0, m_cells, m_levels - 1);
+
+    m_changedMinX = 0;
+    m_changedMinZ = 0;
+    m_changedMaxX = m_cells;
+    m_changedMaxZ = m_cells;
+}
+
+Terrain::~Terrain() {
+    for (Node& node : m_nodes) {
+        MeshCache::release(node.mesh);
+    }
+    MeshCache::release(m_indexMesh);
+}
+
+int Terrain::buildNode(int x, int z, int cells, int level) {
+    int index = (int)m_nodes.size();
+    m_nodes.push_back(Node());
+
+    Node& node = m_nodes[index];
+    node.x = x;
+    node.z = z;
+    node.cells = cells;
+    node.level = level;
+    node.minY = 0.0f;
+    node.maxY = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        node.children[i] = -1;
+    }
+
+    if (level > 0) {
+        int half = cells / 2;
+        int children[4];
+        for (int i = 0; i < 4; i++) {
+            children[i] = buildNode(x + (i & 1) * half, z + (i >> 1) * half, half, level - 1);
+        }
+        // push_back may have moved the node
+        std::copy(children, children + 4, m_nodes[index].children);
+    }
+    return index;
+}
+
+void Terrain::setHeight(int x, int z, float height) {
+    int samples = m_cells + 1;
+    if (x < 0 || z < 0 || x >= samples || z >= samples) {
+        return;
+    }
+
+    m_heights[(size_t)z * samples + x] = height;
+    m_changedMinX = std::min(m_changedMinX, x);
+    m_changedMinZ = std::min(m_changedMinZ, z);
+    m_changedMaxX = std::max(m_changedMaxX, x);
+    m_changedMaxZ = std::max(m_changedMaxZ, z);
+}
+
+float Terrain::getHeight(int x, int z) const {
+    int samples = m_cells + 1;
+    x = std::max(0, std::min(samples - 1, x));
+    z = std::max(0, std::min(samples - 1, z));
+    return m_heights[(size_t)z * samples + x];
+}
+
+float Terrain::heightAt(float worldX, float worldZ) const {
+    float fx = (worldX - m_origin.x) / m_spacing;
+    float fz = (worldZ - m_origin.z) / m_spacing;
+    if (!(fx >= 0.0f && fz >= 0.0f && fx <= (float)m_cells && fz <= (float)m_cells)) {
+        return m_origin.y;
+    }
+
+    int x = std::min((int)fx, m_cells - 1);
+    int z = std::min((int)fz, m_cells - 1);
+    float tx = fx - x;
+    float tz = fz - z;
+
+    float h0 = getHeight(x, z) * (1.0f - tx) + getHeight(x + 1, z) * tx;
+    float h1 = getHeight(x, z + 1) * (1.0f - tx) + getHeight(x + 1, z + 1) * tx;
+    return m_origin.y + h0 * (1.0f - tz) + h1 * tz;
+}
+
+AABB Terrain::getBounds() {
+    refresh();
+    return nodeBounds(m_nodes[0]);
+}
+
+AABB Terrain::nodeBounds(const Node& node) const {
+    glm::vec3 min(m_origin.x + node.x * m_spacing, m_origin.y + node.minY, m_origin.z + node.z * m_spacing);
+    glm::vec3 max(min.x + node.cells * m_spacing, m_origin.y + node.maxY, min.z + node.cells * m_spacing);
+    return AABB(min, max);
+}
+
+void Terrain::refresh() {
+    if (m_changedMaxX < m_changedMinX) {
+        return;
+    }
+
+    refreshNode(0);
+    m_changedMinX = m_cells + 1;
+    m_changedMinZ = m_cells + 1;
+    m_changedMaxX = -1;
+    m_changedMaxZ = -1;
+}
+
+void Terrain::refreshNode(int index) {
+    Node& node = m_nodes[index];
+    // Normals reach one sample past the edge, so neighbours of a changed sample are rebuilt too
+    if (node.x > m_changedMaxX + 1 || node.x + node.cells < m_changedMinX - 1 ||
+        node.z > m_changedMaxZ + 1 || node.z + node.cells < m_changedMinZ - 1) {
+        return;
+    }
+
+    node.dirty = true;
+    if (node.children[0] < 0) {
+        int samples = m_cells + 1;
+        node.minY = node.maxY = m_heights[(size_t)node.z * samples + node.x];
+        for (int z = node.z; z <= node.z + node.cells; z++) {
+            const float* row = &m_heights[(size_t)z * samples];
+            for (int x = node.x; x <= node.x + node.cells; x++) {
+                node.minY = std::min(node.minY, row[x]);
+                node.maxY = std::max(node.maxY, row[x]);
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        refreshNode(node.children[i]);
+    }
+
+    node.minY = m_nodes[node.children[0]].minY;
+    node.maxY = m_nodes[node.children[0]].maxY;
+    for (int i = 1; i < 4; i++) {
+        node.minY = std::min(node.minY, m_nodes[node.children[i]].minY);
+        node.maxY = std::max(node.maxY, m_nodes[node.children[i]].maxY);
+    }
+}
+
+glm::vec3 Terrain::sampleNormal(int x, int z) const {
+    float dx = getHeight(x - 1, z) - getHeight(x + 1, z);
+    float dz = getHeight(x, z - 1) - getHeight(x, z + 1);
+    return glm::normalize(glm::vec3(dx, 2.0f * m_spacing, dz));
+}
+
+void Terrain::bake(Node& node, RenderPacket& packet) {
+    int stride = node.cells / kChunkCells;
+    float skirtDepth = (node.maxY - node.minY) + stride * m_spacing;
+
+    if (!node.mesh) {
+        node.mesh = MeshCache::createId();
+    }
+    std::vector<float>& vertices = packet.addUpload(node.mesh).vertices;
+    vertices.reserve((kGridVertices + 4 * (kChunkCells + 1)) * kFloatsPerVertex);
+
+    auto addVertex = [&](int i, int j, float drop) {
+        int x = node.x + i * stride;
+        int z = node.z + j * stride;
+        glm::vec3 normal = sampleNormal(x, z);
+        vertices.push_back(m_origin.x + x * m_spacing);
+        vertices.push_back(m_origin.y + getHeight(x, z) - drop);
+        vertices.push_back(m_origin.z + z * m_spacing);
+        vertices.push_back(normal.x);
+        vertices.push_back(normal.y);
+        vertices.push_back(normal.z);
+    };
+
+    for (int j = 0; j <= kChunkCells; j++) {
+        for (int i = 0; i <= kChunkCells; i++) {
+            addVertex(i, j, 0.0f);
+        }
+    }
+
+    // Skirts hang below the four edges, in the order createIndexBuffer expects
+    for (int k = 0; k <= kChunkCells; k++) addVertex(k, 0, skirtDepth);
+    for (int k = 0; k <= kChunkCells; k++) addVertex(k, kChunkCells, skirtDepth);
+    for (int k = 0; k <= kChunkCells; k++) addVertex(0, k, skirtDepth);
+    for (int k = 0; k <= kChunkCells; k++) addVertex(kChunkCells, k, skirtDepth);
+
+    node.dirty = false;
+}
+
+void Terrain::createIndexBuffer(RenderPacket& packet) {
+    const int n = kChunkCells;
+    auto grid = [n](int i, int j) { return (GLushort)(j * (n + 1) + i); };
+
+    m_indexMesh = MeshCache::createId();
+    std::vector<GLushort>& indices = packet.addUpload(m_indexMesh).indices;
+    indices.reserve(6 * n * n + 4 * 6 * n);
+
+    // Counter clockwise seen from above
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            indices.push_back(grid(i, j));
+            indices.push_back(grid(i, j + 1));
+            indices.push_back(grid(i + 1, j));
+
+            indices.push_back(grid(i + 1, j));
+            indices.push_back(grid(i, j + 1));
+            indices.push_back(grid(i + 1, j + 1));
+        }
+    }
+
+    // Edges in bake order: z min, z max, x min, x max. Flipped edges face the other way.
+    const bool flip[4] = {false, true, true, false};
+    for (int edge = 0; edge < 4; edge++) {
+        GLushort skirt = (GLushort)(kGridVertices + edge * (n + 1));
+        for (int k = 0; k < n; k++) {
+            GLushort e0, e1;
+            switch (edge) {
+                case 0:  e0 = grid(k, 0); e1 = grid(k + 1, 0); break;
+                case 1:  e0 = grid(k, n); e1 = grid(k + 1, n); break;
+                case 2:  e0 = grid(0, k); e1 = grid(0, k + 1); break;
+                default: e0 = grid(n, k); e1 = grid(n, k + 1); break;
+            }
+            GLushort s0 = (GLushort)(skirt + k);
+            GLushort s1 = (GLushort)(skirt + k + 1);
+
+            GLushort tri[6] = {e0, e1, s0, e1, s1, s0};
+            if (flip[edge]) {
+                std::swap(tri[1], tri[2]);
+                std::swap(tri[4], tri[5]);
+            }
+            indices.insert(indices.end(), tri, tri + 6);
+        }
+    }
+
+    m_indexCount = (int)indices.size();
+}
+
+int Terrain::draw(const Frustum* frustum, const glm::vec3& cameraPos, RenderPacket& packet) {
+    refresh();
+    if (!m_indexMesh) {
+        createIndexBuffer(packet);
+    }
+    return selectNode(0, frustum, cameraPos, packet);
+}
+
+int Terrain::selectNode(int index, const Frustum* frustum, const glm::vec3& cameraPos, RenderPacket& packet) {
+    AABB bounds = nodeBounds(m_nodes[index]);
+    if (frustum && !frustum->isAABBVisible(bounds)) {
+        return 0;
+    }
+
+    // A node is drawn once the camera is past the range of the level below it
+    const Node& node = m_nodes[index];
+    float distance = glm::distance(cameraPos, glm::clamp(cameraPos, bounds.min, bounds.max));
+    if (node.children[0] < 0 || distance > m_lodRange * (float)(1 << (node.level - 1))) {
+        drawNode(m_nodes[index], packet);
+        return 1;
+    }
+
+    int drawn = 0;
+    for (int i = 0; i < 4; i++) {
+        drawn += selectNode(node.children[i], frustum, cameraPos, packet);
+    }
+    return drawn;
+}
+
+void Terrain::drawNode(Node& node, RenderPacket& packet) {
+    if (node.dirty) {
+        bake(node, packet);
+    }
+    packet.meshes.push_back({node.mesh, m_indexMesh, GL_TRIANGLES, m_indexCount});
+}
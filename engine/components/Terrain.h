@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../scene/AABB.h"
+#include "../graphics/Frustum.h"
+#include "../graphics/RenderPacket.h"
+
+// Heightfield terrain drawn as chunks from a quadtree. Every chunk uses the same grid of
+// kChunkCells x kChunkCells quads, a chunk one level up covers four times the area with every
+// other sample. Each frame the tree is walked from the root, nodes outside the frustum are dropped
+// and nodes far enough from the camera are drawn at their level, so the work per frame depends on
+// the view and not on the terrain size. Chunks get skirts to hide cracks between levels.
+class Terrain {
+public:
+    static const int kChunkCells = 32;
+
+    // cellsPerSide is rounded up to kChunkCells times a power of two, the terrain starts flat
+    Terrain(int cellsPerSide, float spacing, const glm::vec3& origin = glm::vec3(0.0f));
+    ~Terrain();
+
+    int getSamplesPerSide() const { return m_cells + 1; }
+    float getSpacing() const { return m_spacing; }
+    const glm::vec3& getOrigin() const { return m_origin; }
+    int getLevelCount() const { return m_levels; }
+    AABB getBounds();
+
+    // Sample coordinates, 0 to getSamplesPerSide() - 1. Changed chunks are rebuilt on the next draw.
+    void setHeight(int x, int z, float height);
+    float getHeight(int x, int z) const;
+    // World height under a point, bilinear between samples, origin.y outside the terrain
+    float heightAt(float worldX, float worldZ) const;
+
+    // Distance up to which the finest chunks are used, every level after that doubles it
+    void setLodRange(float range) { m_lodRange = range; }
+    float getLodRange() const { return m_lodRange; }
+
+    // Adds the chunks to draw to the packet, frustum may be null. Returns the number of chunks drawn.
+    int draw(const Frustum* frustum, const glm::vec3& cameraPos, RenderPacket& packet);
+
+private:
+    struct Node {
+        int x, z;          // first sample
+        int cells;         // cells per side
+        int level;         // 0 for the finest chunks
+        int children[4];   // -1 for leaves
+        float minY, maxY;
+        uint64_t mesh = 0; // MeshCache id
+        bool dirty = true;
+    };
+
+    int m_cells;
+    int m_levels;
+    float m_spacing;
+    glm::vec3 m_origin;
+    float m_lodRange;
+
+    std::vector<float> m_heights;
+    std::vector<Node> m_nodes;
+
+    uint64_t m_indexMesh;
+    int m_indexCount;
+
+    // Sample rectangle changed since the last draw, empty when max < min
+    int m_changedMinX, m_changedMinZ, m_changedMaxX, m_changedMaxZ;
+
+    int buildNode(int x, int z, int cells, int level);
+    void refresh();
+    void refreshNode(int index);
+    AABB nodeBounds(const Node& node) const;
+    glm::vec3 sampleNormal(int x, int z) const;
+    void bake(Node& node, RenderPacket& packet);
+    void createIndexBuffer(RenderPacket& packet);
+    int selectNode(int index, const Frustum* frustum, const glm::vec3& cameraPos, RenderPacket& packet);
+    void drawNode(Node& node, RenderPacket& packet);
+};
@@ -0,0 +1,57 @@
+#include "AllocationCounter.h"
+
+#ifdef ENGINE_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> s_allocations(0);
+
+void* countedAllocate(size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* countedAllocateOrThrow(size_t size) {
+    void* result = countedAllocate(size);
+    if (!result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+}
+
+// The over-aligned forms (ECS chunks) are left to the standard library and not counted
+void* operator new(size_t size) { return countedAllocateOrThrow(size); }
+void* operator new[](size_t size) { return countedAllocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+bool AllocationCounter::isEnabled() {
+    return true;
+}
+
+uint64_t AllocationCounter::getCount() {
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled() {
+    return false;
+}
+
+uint64_t AllocationCounter::getCount() {
+    return 0;
+}
+
+#endif
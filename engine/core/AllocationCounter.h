@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Counts every global operator new on any thread, for checking that steady frames don't touch
+// the heap. Only built in with ENGINE_COUNT_ALLOCATIONS (cmake -DENGINE_COUNT_ALLOCATIONS=ON),
+// otherwise the count stays 0.
+class AllocationCounter {
+public:
+    static bool isEnabled();
+    static uint64_t getCount();
+};
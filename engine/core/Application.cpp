@@ -2,65 +2,124 @@
 #include <GLFW/glfw3.h>
 #include "Application.h"
 #include "Engine.h"
+#include "AllocationCounter.h"
 #include <iostream>
 #include <iomanip>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
 
-Application::Application(int width, int height, const char* title)
+namespace {
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+Application::Application(int width, int height, const char* title, RenderBackendType backend)
     : m_width(width), m_height(height), m_title(title),
-      m_camera(nullptr), m_input(nullptr), m_activeScene(nullptr),
+      m_camera(nullptr), m_input(nullptr), m_jobs(nullptr), m_activeScene(nullptr),
       m_defaultFrustumCulling(true), m_defaultBatchRendering(true),
-      m_defaultOctree(true)
+      m_defaultOctree(true),
+      m_fixedUpdateRate(60.0), m_maxUpdatesPerFrame(5), m_frameLimit(0),
+      m_profileFrames(false), m_recordPath(nullptr), m_replayPath(nullptr), m_frameAllocations(0),
+      m_useRenderThread(true), m_pendingPacket(-1), m_drawingPacket(-1), m_stopRendering(false)
 {
-    if (!glfwInit()) {
-        std::cerr << "Failed to init GLFW\n";
-        exit(-1);
+    m_backend = RenderBackend::create(backend);
+    m_initialized = m_backend->initialize(width, height, title);
+    if (!m_initialized) {
+        std::cerr << "Failed to start the " << RenderBackend::getTypeName(backend) << " render backend\n";
     }
-
-    GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        exit(-1);
-    }
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1); // Enable vsync
-
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to init GLEW\n";
-        exit(-1);
-    }
-
-    std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
-
-    m_renderer = new Renderer(window);
+    m_jobs = new JobSystem();
 }
 
 Application::~Application() {
+    finishLoadingScenes(true);
     for (auto& pair : m_scenes) {
         delete pair.second;
     }
+    delete m_jobs;
 
-    delete m_renderer;
-    glfwTerminate();
+    delete m_backend;
 }
 
 Scene* Application::createScene(const std::string& name) {
+    if (m_loadingScenes.count(name)) {
+        std::cerr << "Scene '" << name << "' is still loading, waiting for it\n";
+        m_loadingScenes[name].ready.wait();
+        finishLoadingScenes(false);
+    }
     if (m_scenes.find(name) != m_scenes.end()) {
         std::cerr << "Scene '" << name << "' already exists!\n";
         return m_scenes[name];
     }
 
     Scene* scene = new Scene(name);
+    addScene(name, scene);
+    return scene;
+}
+
+void Application::addScene(const std::string& name, Scene* scene) {
     scene->inheritSettings(m_defaultFrustumCulling, m_defaultBatchRendering, m_defaultOctree);
     scene->setLODSettings(m_defaultLODSettings);
+    scene->setJobSystem(m_jobs);
     m_scenes[name] = scene;
 
     if (!m_activeScene) {
         m_activeScene = scene;
     }
+}
 
-    return scene;
+std::shared_future<Scene*> Application::createSceneAsync(const std::string& name,
+                                                         const std::function<void(Scene*)>& build) {
+    auto loading = m_loadingScenes.find(name);
+    if (loading != m_loadingScenes.end()) {
+        std::cerr << "Scene '" << name << "' is already loading!\n";
+        return loading->second.ready;
+    }
+    if (m_scenes.find(name) != m_scenes.end()) {
+        std::cerr << "Scene '" << name << "' already exists!\n";
+        std::promise<Scene*> existing;
+        existing.set_value(m_scenes[name]);
+        return existing.get_future().share();
+    }
+
+    // Made here, the scene's renderers create GL objects. The settings are given before the
+    // build starts since they decide which indices it fills.
+    Scene* scene = new Scene(name);
+    scene->inheritSettings(m_defaultFrustumCulling, m_defaultBatchRendering, m_defaultOctree);
+    scene->setLODSettings(m_defaultLODSettings);
+
+    std::shared_future<Scene*> ready = std::async(std::launch::async, [scene, build]() {
+        build(scene);
+        return scene;
+    }).share();
+    m_loadingScenes[name] = {scene, ready};
+    return ready;
+}
+
+void Application::finishLoadingScenes(bool wait) {
+    for (auto it = m_loadingScenes.begin(); it != m_loadingScenes.end();) {
+        LoadingScene& loading = it->second;
+        if (!wait && loading.ready.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        loading.ready.wait();
+        std::string name = it->first;
+        Scene* scene = loading.scene;
+        it = m_loadingScenes.erase(it);
+        // Again, the defaults may have changed while it was loading
+        addScene(name, scene);
+        std::cout << "Loaded scene: " << name << std::endl;
+
+        if (m_switchWhenLoaded == name) {
+            m_switchWhenLoaded.clear();
+            setActiveScene(name);
+        }
+    }
 }
 
 Scene* Application::getScene(const std::string& name) {
@@ -72,8 +131,15 @@ Scene* Application::getScene(const std::string& name) {
 }
 
 void Application::setActiveScene(const std::string& name) {
+    if (m_loadingScenes.count(name)) {
+        m_switchWhenLoaded = name;
+        std::cout << "Scene " << name << " is loading, switching when it is ready" << std::endl;
+        return;
+    }
+
     Scene* scene = getScene(name);
     if (scene) {
+        m_switchWhenLoaded.clear();
         m_activeScene = scene;
         std::cout << "Switched to scene: " << name << std::endl;
     } else {
@@ -82,6 +148,15 @@ void Application::setActiveScene(const std::string& name) {
 }
 
 void Application::deleteScene(const std::string& name) {
+    if (m_switchWhenLoaded == name) {
+        m_switchWhenLoaded.clear();
+    }
+    auto loading = m_loadingScenes.find(name);
+    if (loading != m_loadingScenes.end()) {
+        loading->second.ready.wait();
+        finishLoadingScenes(false);
+    }
+
     auto it = m_scenes.find(name);
     if (it != m_scenes.end()) {
         if (m_activeScene == it->second) {
@@ -99,8 +174,8 @@ void Application::setCamera(FlyCamera* camera) {
 
 void Application::setInputManager(InputManager* input) {
     m_input = input;
-    if (m_input && m_renderer) {
-        m_input->setMouseCallback(m_renderer->getWindow());
+    if (m_input && m_backend->getWindow()) {
+        m_input->setMouseCallback(m_backend->getWindow());
     }
 }
 
@@ -141,65 +216,178 @@ void Application::checkSceneSwitching() {
     key3WasPressed = key3Pressed;
 }
 
+void Application::setFixedUpdateRate(double hz) {
+    if (hz <= 0.0) {
+        std::cerr << "Fixed update rate must be above 0, got " << hz << std::endl;
+        return;
+    }
+    m_fixedUpdateRate = hz;
+}
+
 void Application::run() {
-    GLFWwindow* window = m_renderer->getWindow();
+    if (!m_initialized) {
+        std::cerr << "No render backend, not running\n";
+        return;
+    }
+
+    GLFWwindow* window = m_backend->getWindow();
     int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    glViewport(0, 0, width, height);
+    m_backend->getFramebufferSize(width, height);
 
     float aspect = (float)width / (float)height;
     m_projectionMatrix = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glMultMatrixf(&m_projectionMatrix[0][0]);
-
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    GLfloat lightPos[] = {5.0f, 5.0f, 5.0f, 1.0f};
-    GLfloat lightAmbient[] = {0.3f, 0.3f, 0.3f, 1.0f};
-    GLfloat lightDiffuse[] = {0.8f, 0.8f, 0.8f, 1.0f};
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
-
-    GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    GLfloat matShininess[] = {50.0f};
-    glMaterialfv(GL_FRONT, GL_SPECULAR, matSpecular);
-    glMaterialfv(GL_FRONT, GL_SHININESS, matShininess);
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-    glEnable(GL_COLOR_MATERIAL);
+    // The context moves to the render thread for as long as the loop runs
+    if (m_useRenderThread) {
+        m_stopRendering = false;
+        m_backend->makeCurrent(false);
+        m_renderThread = std::thread(&Application::renderLoop, this, width, height);
+    } else {
+        m_backend->setupState(width, height);
+    }
 
     int frameCount = 0;
-    double lastTime = glfwGetTime();
+    int framesRun = 0;
+    double lastTime = m_backend->getTime();
+    int fill = 0;
 
-    while (!glfwWindowShouldClose(window)) {
-        if (m_input) {
-            m_input->update(window);
-        }
+    double previousTime = lastTime;
+    double accumulator = 0.0;
+    Scene* updatedScene = nullptr;
+    size_t replayFrame = 0;
 
-        checkSceneSwitching();
+    uint64_t secondAllocations = 0;
 
-        if (m_camera) {
-            m_camera->update();
+    if (m_profileFrames) {
+        m_profiler.reset(m_replayPath ? m_replayPath->size() : (size_t)m_frameLimit);
+    }
+    m_packets[0].profileFrame = -1;
+    m_packets[1].profileFrame = -1;
+
+    while (!m_backend->shouldClose() && (m_frameLimit == 0 || framesRun < m_frameLimit) &&
+           (!m_replayPath || replayFrame < m_replayPath->size())) {
+        uint64_t allocationsBefore = AllocationCounter::getCount();
+
+        // Every stage adds the time since the last one ended
+        double frameStart = nowMs();
+        double stageStart = frameStart;
+        long long profileFrame = m_profileFrames ? (long long)m_profiler.beginFrame() : -1;
+        auto endStage = [&](FrameStage stage) {
+            double now = nowMs();
+            if (profileFrame >= 0) {
+                m_profiler.getFrame((size_t)profileFrame).stageMs[static_cast<int>(stage)] += now - stageStart;
+            }
+            stageStart = now;
+        };
+
+        m_frameArena.reset();
+
+        // A replay ignores the keyboard, scene switches included
+        if (m_input && window && !m_replayPath) {
+            m_input->update(window);
         }
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        finishLoadingScenes(false);
+        if (!m_replayPath) {
+            checkSceneSwitching();
+        }
+        endStage(FrameStage::Input);
+
+        float alpha = 1.0f;
+        if (m_replayPath) {
+            // One pose and one fixed update per frame whatever the clock says, so every replay
+            // of the path does the same work
+            const CameraPose& pose = (*m_replayPath)[replayFrame++];
+            if (m_camera) {
+                m_camera->setPose(pose.position, pose.yaw, pose.pitch);
+            }
+            if (m_activeScene) {
+                m_activeScene->update(m_camera, m_projectionMatrix);
+                updatedScene = m_activeScene;
+            }
+        } else {
+            double now = m_backend->getTime();
+            accumulator += now - previousTime;
+            previousTime = now;
+
+            double step = 1.0 / m_fixedUpdateRate;
+            int updates = 0;
+            while (accumulator >= step && updates < m_maxUpdatesPerFrame) {
+                if (m_camera) {
+                    m_camera->update((float)step);
+                }
+                if (m_activeScene) {
+                    m_activeScene->update(m_camera, m_projectionMatrix);
+                    updatedScene = m_activeScene;
+                }
+                accumulator -= step;
+                updates++;
+            }
+            // Behind by more than the cap, the simulation slows down instead of spiralling
+            if (accumulator >= step) {
+                accumulator = std::fmod(accumulator, step);
+            }
+            alpha = (float)(accumulator / step);
+        }
+        // A scene that was just switched to gets its indices flushed before it is culled
+        if (m_activeScene && m_activeScene != updatedScene) {
+            m_activeScene->update(m_camera, m_projectionMatrix);
+            updatedScene = m_activeScene;
+        }
+        if (m_recordPath && m_camera) {
+            m_recordPath->add({m_camera->getPosition(), m_camera->getYaw(), m_camera->getPitch()});
+        }
+        endStage(FrameStage::Update);
 
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
+        // Waits while the render thread still draws from this buffer, two frames back
+        RenderPacket& packet = m_packets[fill];
+        if (m_useRenderThread) {
+            std::unique_lock<std::mutex> lock(m_renderMutex);
+            m_renderSignal.wait(lock, [this, fill]() { return m_pendingPacket != fill && m_drawingPacket != fill; });
+        }
+        endStage(FrameStage::Wait);
+        collectDrawTimes(packet);
+        packet.profileFrame = profileFrame;
+        packet.clear();
+        packet.projection = m_projectionMatrix;
         if (m_camera) {
-            glm::mat4 view = m_camera->getViewMatrix();
-            glMultMatrixf(&view[0][0]);
+            packet.view = m_camera->getInterpolatedViewMatrix(alpha);
         }
 
         if (m_activeScene) {
-            m_activeScene->update(m_camera, m_projectionMatrix);
-            m_activeScene->render(m_renderer, m_camera);
+            m_activeScene->buildRenderPacket(packet, m_camera, m_frameArena, alpha);
+        }
+        MeshCache::takeReleased(packet.releases);
+        if (profileFrame >= 0 && m_activeScene) {
+            FrameRecord& record = m_profiler.getFrame((size_t)profileFrame);
+            record.rendered = m_activeScene->getCullingStats().rendered;
+            record.culled = m_activeScene->getCullingStats().frustumCulled;
+        }
+        endStage(FrameStage::Cull);
+
+        if (m_useRenderThread) {
+            std::unique_lock<std::mutex> lock(m_renderMutex);
+            m_renderSignal.wait(lock, [this]() { return m_pendingPacket < 0; });
+            m_pendingPacket = fill;
+            m_renderSignal.notify_all();
+            fill ^= 1;
+            endStage(FrameStage::Wait);
+        } else {
+            m_renderArena.reset();
+            packet.profileFrame = -1;
+            m_backend->submit(packet, m_renderArena);
+            endStage(FrameStage::Draw);
+            m_backend->present();
+            endStage(FrameStage::Present);
         }
 
+        // Counts the render thread too, whatever it allocated while this frame was built
+        m_frameAllocations = AllocationCounter::getCount() - allocationsBefore;
+        secondAllocations += m_frameAllocations;
+
         frameCount++;
-        double currentTime = glfwGetTime();
+        framesRun++;
+        double currentTime = m_backend->getTime();
         if (currentTime - lastTime >= 1.0) {
             if (m_activeScene) {
                 const CullingStats& stats = m_activeScene->getCullingStats();
@@ -208,14 +396,80 @@ void Application::run() {
                           << " | Scene: " << std::setw(12) << std::left << m_activeScene->getName()
                           << " | Total: " << std::setw(6) << std::right << stats.totalEntities
                           << " | Rendered: " << std::setw(6) << stats.rendered
-                          << " | Culled: " << std::setw(6) << stats.frustumCulled
-                          << std::endl;
+                          << " | Culled: " << std::setw(6) << stats.frustumCulled;
+                if (AllocationCounter::isEnabled()) {
+                    std::cout << " | Allocs/frame: " << secondAllocations / frameCount;
+                }
+                std::cout << std::endl;
             }
             frameCount = 0;
+            secondAllocations = 0;
             lastTime = currentTime;
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        m_backend->pollEvents();
+        endStage(FrameStage::Input);
+        if (profileFrame >= 0) {
+            m_profiler.getFrame((size_t)profileFrame).frameMs = nowMs() - frameStart;
+        }
+    }
+
+    if (m_useRenderThread) {
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_stopRendering = true;
+        }
+        m_renderSignal.notify_all();
+        m_renderThread.join();
+        m_backend->makeCurrent(true);
+    }
+
+    if (m_profileFrames) {
+        collectDrawTimes(m_packets[0]);
+        collectDrawTimes(m_packets[1]);
+        m_profiler.printSummary();
+    }
+}
+
+void Application::collectDrawTimes(RenderPacket& packet) {
+    if (packet.profileFrame >= 0 && (size_t)packet.profileFrame < m_profiler.getFrames().size()) {
+        FrameRecord& record = m_profiler.getFrame((size_t)packet.profileFrame);
+        record.stageMs[static_cast<int>(FrameStage::Draw)] += packet.drawMs;
+        record.stageMs[static_cast<int>(FrameStage::Present)] += packet.presentMs;
+    }
+    packet.profileFrame = -1;
+}
+
+void Application::renderLoop(int width, int height) {
+    m_backend->makeCurrent(true);
+    m_backend->setupState(width, height);
+
+    std::unique_lock<std::mutex> lock(m_renderMutex);
+    while (true) {
+        // A packet submitted before the stop is still drawn, it may free meshes
+        m_renderSignal.wait(lock, [this]() { return m_pendingPacket >= 0 || m_stopRendering; });
+        if (m_pendingPacket < 0) {
+            break;
+        }
+
+        m_drawingPacket = m_pendingPacket;
+        m_pendingPacket = -1;
+        lock.unlock();
+        m_renderSignal.notify_all();
+
+        RenderPacket& packet = m_packets[m_drawingPacket];
+        m_renderArena.reset();
+        double drawStart = nowMs();
+        m_backend->submit(packet, m_renderArena);
+        double drawEnd = nowMs();
+        m_backend->present();
+        packet.drawMs = drawEnd - drawStart;
+        packet.presentMs = nowMs() - drawEnd;
+
+        lock.lock();
+        m_drawingPacket = -1;
+        m_renderSignal.notify_all();
     }
+
+    m_backend->makeCurrent(false);
 }
\ No newline at end of file
@@ -2,18 +2,39 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <future>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "../graphics/Renderer.h"
+#include "../graphics/RenderBackend.h"
 #include "../components/FlyCamera.h"
 #include "InputManager.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "FrameProfiler.h"
+#include "../components/CameraPath.h"
 #include "../scene/Scene.h"
 #include "../systems/LODSystem.h"
 
 class Application {
 public:
-    Application(int width, int height, const char* title);
+    // A failed backend is reported on std::cerr, isInitialized() is then false and run() returns
+    // right away. Scenes can still be made and updated without one.
+    Application(int width, int height, const char* title, RenderBackendType backend = RenderBackendType::Window);
     ~Application();
 
+    bool isInitialized() const { return m_initialized; }
+
     Scene* createScene(const std::string& name);
+    // Runs build on a worker thread and adds the scene once it returns, the frames in between
+    // keep rendering the active scene. build gets the scene to itself, it must not make GL calls.
+    // Until then getScene() returns nullptr and setActiveScene() waits for it.
+    std::shared_future<Scene*> createSceneAsync(const std::string& name, const std::function<void(Scene*)>& build);
+    bool isSceneLoading(const std::string& name) const { return m_loadingScenes.count(name) > 0; }
+    // Blocks until every scene from createSceneAsync() is added
+    void waitForLoadingScenes() { finishLoadingScenes(true); }
     Scene* getScene(const std::string& name);
     void setActiveScene(const std::string& name);
     Scene* getActiveScene() { return m_activeScene; }
@@ -33,23 +54,72 @@ public:
     bool getBatchRenderingEnabled() const { return m_defaultBatchRendering; }
     bool getOctreeEnabled() const { return m_defaultOctree; }
 
+    // Draws on a second thread that owns the GL context, so the next frame is simulated while
+    // the last one is drawn. Set before run(), off draws on the main thread.
+    void enableRenderThread(bool enable) { m_useRenderThread = enable; }
+    bool getRenderThreadEnabled() const { return m_useRenderThread; }
+
+    // The camera and Scene::update() run at a fixed rate, decoupled from how fast frames are
+    // drawn. Frames in between draw the camera interpolated between its last two updates.
+    // After a hitch at most maxUpdates steps run in one frame and the rest of the time is dropped.
+    void setFixedUpdateRate(double hz);
+    double getFixedUpdateRate() const { return m_fixedUpdateRate; }
+    void setMaxUpdatesPerFrame(int maxUpdates) { m_maxUpdatesPerFrame = maxUpdates > 0 ? maxUpdates : 1; }
+    int getMaxUpdatesPerFrame() const { return m_maxUpdatesPerFrame; }
+
+    // run() returns after this many frames, 0 runs until the window closes. Headless backends
+    // never close on their own.
+    void setFrameLimit(int frames) { m_frameLimit = frames > 0 ? frames : 0; }
+    int getFrameLimit() const { return m_frameLimit; }
+
+    // Applied when run() starts
+    void setVsync(bool enable) { m_backend->setVsync(enable); }
+
+    // Times the stages of every frame of the next run() calls, which print the frame time
+    // percentiles, stage times and culling stats when they return. Each run() starts over.
+    void enableFrameProfiling(bool enable) { m_profileFrames = enable; }
+    const FrameProfiler& getFrameProfiler() const { return m_profiler; }
+
+    // Adds the camera pose of every frame to path, nullptr stops recording
+    void recordCameraPath(CameraPath* path) { m_recordPath = path; }
+    // Sets the camera from path instead of from input, with one fixed update per frame however
+    // long frames take, and run() returns after the last pose. Two replays of a path do the
+    // same work, so their timings can be compared. nullptr goes back to input.
+    void replayCameraPath(const CameraPath* path) { m_replayPath = path; }
+
     void run();
 
-    Renderer* getRenderer() { return m_renderer; }
+    RenderBackend* getBackend() { return m_backend; }
+    // nullptr with the null backend
+    Renderer* getRenderer() { return m_backend->getRenderer(); }
+    // Shared worker threads, one per core besides the main thread
+    JobSystem* getJobSystem() { return m_jobs; }
     glm::mat4 getProjectionMatrix() const { return m_projectionMatrix; }
+    // Heap allocations during the last frame, on all threads. Always 0 unless the engine is
+    // built with ENGINE_COUNT_ALLOCATIONS, see AllocationCounter.
+    uint64_t getFrameAllocations() const { return m_frameAllocations; }
 
     void checkSceneSwitching();
 
 private:
     int m_width, m_height;
     const char* m_title;
-    Renderer* m_renderer;
+    RenderBackend* m_backend;
+    bool m_initialized;
     FlyCamera* m_camera;
     InputManager* m_input;
+    JobSystem* m_jobs;
 
     std::unordered_map<std::string, Scene*> m_scenes;
     Scene* m_activeScene;
 
+    struct LoadingScene {
+        Scene* scene;
+        std::shared_future<Scene*> ready;
+    };
+    std::unordered_map<std::string, LoadingScene> m_loadingScenes;
+    std::string m_switchWhenLoaded;
+
     bool m_defaultFrustumCulling;
     bool m_defaultBatchRendering;
     bool m_defaultOctree;
@@ -57,5 +127,35 @@ private:
 
     glm::mat4 m_projectionMatrix;
 
+    double m_fixedUpdateRate;
+    int m_maxUpdatesPerFrame;
+    int m_frameLimit;
+
+    bool m_profileFrames;
+    FrameProfiler m_profiler;
+    CameraPath* m_recordPath;
+    const CameraPath* m_replayPath;
+
+    // Scratch memory for one frame, reset when the next frame starts. One for building packets
+    // on the main thread and one for drawing them.
+    FrameArena m_frameArena;
+    FrameArena m_renderArena;
+    uint64_t m_frameAllocations;
+
+    // The main thread fills one packet while the render thread draws the other. -1 for none.
+    bool m_useRenderThread;
+    std::thread m_renderThread;
+    RenderPacket m_packets[2];
+    int m_pendingPacket;
+    int m_drawingPacket;
+    bool m_stopRendering;
+    std::mutex m_renderMutex;
+    std::condition_variable m_renderSignal;
+
+    void renderLoop(int width, int height);
+    // Moves the draw and present times the render thread left in packet to its frame
+    void collectDrawTimes(RenderPacket& packet);
     void updateSceneDefaults();
+    void finishLoadingScenes(bool wait);
+    void addScene(const std::string& name, Scene* scene);
 };
\ No newline at end of file
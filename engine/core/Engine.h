@@ -19,10 +19,23 @@ public:
         return s_inputManager;
     }
 
+    static JobSystem* getJobSystem() {
+        return s_application ? s_application->getJobSystem() : nullptr;
+    }
+
     static Scene* createScene(const std::string& name) {
         return s_application ? s_application->createScene(name) : nullptr;
     }
 
+    // Builds the scene on a worker thread, see Application::createSceneAsync
+    static std::shared_future<Scene*> createSceneAsync(const std::string& name, const std::function<void(Scene*)>& build) {
+        return s_application ? s_application->createSceneAsync(name, build) : std::shared_future<Scene*>();
+    }
+
+    static bool isSceneLoading(const std::string& name) {
+        return s_application ? s_application->isSceneLoading(name) : false;
+    }
+
     static Scene* getScene(const std::string& name) {
         return s_application ? s_application->getScene(name) : nullptr;
     }
@@ -91,34 +104,63 @@ public:
         if (s_application) s_application->setLODSettings(settings);
     }
 
-    static Box* createRect(const glm::vec3& position, const glm::vec3& size) {
+    static EntityHandle createRect(const glm::vec3& position, const glm::vec3& size, bool isStatic = false) {
+        Scene* scene = getActiveScene();
+        return scene ? scene->createRect(position, size, isStatic) : EntityHandle();
+    }
+
+    static EntityHandle createRect(const glm::vec3& position, float size = 1.0f, bool isStatic = false) {
+        Scene* scene = getActiveScene();
+        return scene ? scene->createRect(position, size, isStatic) : EntityHandle();
+    }
+
+    static void createRects(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& sizes,
+                            std::vector<EntityHandle>* created = nullptr, bool isStatic = false) {
+        Scene* scene = getActiveScene();
+        if (scene) {
+            scene->createRects(positions, sizes, created, isStatic);
+        }
+    }
+
+    static void removeEntity(EntityHandle entity) {
         Scene* scene = getActiveScene();
-        return scene ? scene->createRect(position, size) : nullptr;
+        if (scene) {
+            scene->removeEntity(entity);
+        }
     }
 
-    static Box* createRect(const glm::vec3& position, float size = 1.0f) {
+    static void setEntityPosition(EntityHandle entity, const glm::vec3& position) {
         Scene* scene = getActiveScene();
-        return scene ? scene->createRect(position, size) : nullptr;
+        if (scene) {
+            scene->setPosition(entity, position);
+        }
+    }
+
+    static void setEntitySize(EntityHandle entity, const glm::vec3& size) {
+        Scene* scene = getActiveScene();
+        if (scene) {
+            scene->setSize(entity, size);
+        }
     }
 
-    static void queryRange(const glm::vec3& center, float radius, std::vector<Box*>& result) {
+    static void queryRange(const glm::vec3& center, float radius, std::vector<EntityHandle>& result) {
         Scene* scene = getActiveScene();
-        if (scene && scene->getOctree()) {
-            scene->getOctree()->queryRange(center, radius, result);
+        if (scene) {
+            scene->queryRange(center, radius, result);
         }
     }
 
-    static void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<Box*>& result) {
+    static void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<EntityHandle>& result) {
         Scene* scene = getActiveScene();
-        if (scene && scene->getOctree()) {
-            scene->getOctree()->queryAABB(min, max, result);
+        if (scene) {
+            scene->queryAABB(min, max, result);
         }
     }
 
-    static bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Box** hitBox) {
+    static bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, EntityHandle* hit) {
         Scene* scene = getActiveScene();
-        if (scene && scene->getOctree()) {
-            return scene->getOctree()->raycast(origin, direction, maxDistance, hitBox);
+        if (scene) {
+            return scene->raycast(origin, direction, maxDistance, hit);
         }
         return false;
     }
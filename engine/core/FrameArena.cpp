@@ -0,0 +1,62 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t blockSize)
+    : m_blockSize(blockSize > 0 ? blockSize : 64 * 1024), m_current(0), m_offset(0), m_used(0) {
+}
+
+FrameArena::~FrameArena() {
+    for (Block& block : m_blocks) {
+        delete[] block.data;
+    }
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    while (true) {
+        if (m_current < m_blocks.size()) {
+            Block& block = m_blocks[m_current];
+            uintptr_t address = (uintptr_t)(block.data + m_offset);
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (m_offset + padding + size <= block.size) {
+                void* result = block.data + m_offset + padding;
+                m_offset += padding + size;
+                m_used += padding + size;
+                return result;
+            }
+            if (m_current + 1 < m_blocks.size()) {
+                m_current++;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        // Room for the padding too, however the new block ends up aligned
+        size_t blockSize = std::max(m_blockSize, size + alignment);
+        m_blocks.push_back({new char[blockSize], blockSize});
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    if (m_blocks.size() > 1) {
+        size_t total = getCapacity();
+        for (Block& block : m_blocks) {
+            delete[] block.data;
+        }
+        m_blocks.clear();
+        m_blocks.push_back({new char[total], total});
+    }
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t total = 0;
+    for (const Block& block : m_blocks) {
+        total += block.size;
+    }
+    return total;
+}
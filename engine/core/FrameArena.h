@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for data that only lives for one frame. Allocating moves a pointer, nothing is
+// freed on its own, reset() at the start of the next frame makes all of it free at once. Blocks
+// are kept across frames, so once the arena has grown to fit a frame it stops allocating.
+// Not thread safe, every thread that needs one gets its own.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    // Frees everything allocated since the last reset. A frame that spilled into more blocks
+    // gets them merged into one, so the same frame fits in one block the next time.
+    void reset();
+
+    size_t getUsed() const { return m_used; }
+    size_t getCapacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    size_t m_current;
+    size_t m_offset;
+    size_t m_used;
+};
+
+// Lets standard containers allocate from a FrameArena. Deallocating does nothing, so a vector
+// that grows leaves its old storage behind until the reset, reserve up front where possible.
+// The container must not outlive the frame.
+template<typename T>
+class FrameAllocator {
+public:
+    using value_type = T;
+
+    explicit FrameAllocator(FrameArena& arena) : m_arena(&arena) {}
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.getArena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* getArena() const { return m_arena; }
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>& other) const { return m_arena == other.getArena(); }
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>& other) const { return m_arena != other.getArena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
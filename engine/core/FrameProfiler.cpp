@@ -0,0 +1,120 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+const int kStageCount = static_cast<int>(FrameStage::Count);
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = (size_t)std::ceil(fraction * sorted.size());
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+}
+
+void FrameProfiler::reset(size_t expectedFrames) {
+    m_frames.clear();
+    m_frames.reserve(expectedFrames);
+}
+
+size_t FrameProfiler::beginFrame() {
+    m_frames.emplace_back();
+    return m_frames.size() - 1;
+}
+
+FrameTimeSummary FrameProfiler::summarize() const {
+    FrameTimeSummary summary;
+    summary.frames = m_frames.size();
+    if (m_frames.empty()) {
+        return summary;
+    }
+
+    std::vector<double> times;
+    times.reserve(m_frames.size());
+    for (const FrameRecord& frame : m_frames) {
+        times.push_back(frame.frameMs);
+        summary.meanMs += frame.frameMs;
+        for (int stage = 0; stage < kStageCount; stage++) {
+            summary.stageMeanMs[stage] += frame.stageMs[stage];
+            summary.stageMaxMs[stage] = std::max(summary.stageMaxMs[stage], frame.stageMs[stage]);
+        }
+        summary.renderedMean += frame.rendered;
+        summary.culledMean += frame.culled;
+    }
+
+    double count = (double)m_frames.size();
+    summary.meanMs /= count;
+    for (int stage = 0; stage < kStageCount; stage++) {
+        summary.stageMeanMs[stage] /= count;
+    }
+    summary.renderedMean /= count;
+    summary.culledMean /= count;
+
+    std::sort(times.begin(), times.end());
+    summary.p50Ms = percentile(times, 0.50);
+    summary.p95Ms = percentile(times, 0.95);
+    summary.p99Ms = percentile(times, 0.99);
+    summary.maxMs = times.back();
+    return summary;
+}
+
+void FrameProfiler::printSummary() const {
+    FrameTimeSummary summary = summarize();
+    std::cout << std::fixed << std::setprecision(3)
+              << "Frames: " << summary.frames
+              << " | mean " << summary.meanMs << " ms"
+              << " | p50 " << summary.p50Ms
+              << " | p95 " << summary.p95Ms
+              << " | p99 " << summary.p99Ms
+              << " | max " << summary.maxMs << std::endl;
+    for (int stage = 0; stage < kStageCount; stage++) {
+        std::cout << "  " << std::setw(8) << std::left << getStageName(static_cast<FrameStage>(stage)) << std::right
+                  << " mean " << std::setw(8) << summary.stageMeanMs[stage]
+                  << " ms | max " << std::setw(8) << summary.stageMaxMs[stage] << " ms" << std::endl;
+    }
+    std::cout << std::setprecision(1)
+              << "  Rendered " << summary.renderedMean << " | Culled " << summary.culledMean
+              << " per frame" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+bool FrameProfiler::writeCsv(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    file << "frame,frame_ms";
+    for (int stage = 0; stage < kStageCount; stage++) {
+        file << ',' << getStageName(static_cast<FrameStage>(stage)) << "_ms";
+    }
+    file << ",rendered,culled\n";
+
+    file << std::fixed << std::setprecision(4);
+    for (size_t i = 0; i < m_frames.size(); i++) {
+        const FrameRecord& frame = m_frames[i];
+        file << i << ',' << frame.frameMs;
+        for (int stage = 0; stage < kStageCount; stage++) {
+            file << ',' << frame.stageMs[stage];
+        }
+        file << ',' << frame.rendered << ',' << frame.culled << '\n';
+    }
+    return (bool)file;
+}
+
+const char* FrameProfiler::getStageName(FrameStage stage) {
+    switch (stage) {
+        case FrameStage::Input:   return "input";
+        case FrameStage::Update:  return "update";
+        case FrameStage::Cull:    return "cull";
+        case FrameStage::Wait:    return "wait";
+        case FrameStage::Draw:    return "draw";
+        case FrameStage::Present: return "present";
+        default:                  return "unknown";
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Where a frame spends its time. With the render thread on, Draw and Present are timed on the
+// render thread and Wait is the main thread blocked on it.
+enum class FrameStage {
+    Input,    // events, input, scene loading and switching
+    Update,   // fixed updates of the camera and scene
+    Cull,     // building the render packet, culling, LOD and instances
+    Wait,     // waiting for a free packet and for the render thread to take it
+    Draw,     // Renderer::submit
+    Present,  // buffer swap
+    Count
+};
+
+struct FrameRecord {
+    double frameMs = 0.0;
+    double stageMs[static_cast<int>(FrameStage::Count)] = {};
+    int rendered = 0;
+    int culled = 0;
+};
+
+struct FrameTimeSummary {
+    size_t frames = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    double stageMeanMs[static_cast<int>(FrameStage::Count)] = {};
+    double stageMaxMs[static_cast<int>(FrameStage::Count)] = {};
+    double renderedMean = 0.0;
+    double culledMean = 0.0;
+};
+
+// Per frame stage timings and culling stats of a run, see Application::enableFrameProfiling
+class FrameProfiler {
+public:
+    // Drops the recorded frames, room for expectedFrames is made up front
+    void reset(size_t expectedFrames);
+    // Index of the new frame, valid until the next reset
+    size_t beginFrame();
+    FrameRecord& getFrame(size_t index) { return m_frames[index]; }
+    const std::vector<FrameRecord>& getFrames() const { return m_frames; }
+
+    // Nearest rank percentiles of the frame times
+    FrameTimeSummary summarize() const;
+    void printSummary() const;
+    // One line per frame: frame time, every stage, rendered and culled
+    bool writeCsv(const std::string& path) const;
+
+    static const char* getStageName(FrameStage stage);
+
+private:
+    std::vector<FrameRecord> m_frames;
+};
@@ -0,0 +1,211 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+struct Job {
+    std::function<void()> fn;
+    JobCounter* counter;
+};
+
+namespace {
+
+// Which pool the current thread works for, so jobs pushed from inside a job stay on that worker
+thread_local const JobSystem* t_pool = nullptr;
+thread_local size_t t_queue = 0;
+
+}
+
+JobCounter::~JobCounter() {
+    for (Job* job : m_waiting) {
+        delete job;
+    }
+}
+
+bool JobCounter::isDone() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count == 0;
+}
+
+JobSystem::JobSystem(int workerCount)
+    : m_queued(0), m_sleeping(0), m_nextVictim(0), m_stop(false) {
+    if (workerCount < 0) {
+        workerCount = (int)std::thread::hardware_concurrency() - 1;
+    }
+    workerCount = std::max(0, workerCount);
+
+    for (int i = 0; i <= workerCount; i++) {
+        m_queues.push_back(new JobQueue());
+    }
+    for (int i = 0; i < workerCount; i++) {
+        m_threads.emplace_back(&JobSystem::workerLoop, this, (size_t)i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+
+    // Without workers nothing ran the jobs nobody waited for
+    while (Job* job = pop()) {
+        execute(job);
+    }
+    for (JobQueue* queue : m_queues) {
+        delete queue;
+    }
+}
+
+size_t JobSystem::ownQueue() const {
+    return t_pool == this ? t_queue : m_queues.size() - 1;
+}
+
+void JobSystem::run(const std::function<void()>& fn, JobCounter* counter) {
+    if (counter) {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        counter->m_count++;
+    }
+    push(new Job{fn, counter});
+}
+
+void JobSystem::runAfter(JobCounter& dependency, const std::function<void()>& fn, JobCounter* counter) {
+    if (counter) {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        counter->m_count++;
+    }
+
+    Job* job = new Job{fn, counter};
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (dependency.m_count > 0) {
+            dependency.m_waiting.push_back(job);
+            return;
+        }
+    }
+    push(job);
+}
+
+void JobSystem::push(Job* job) {
+    JobQueue* queue = m_queues[ownQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->jobs.push_back(job);
+    }
+
+    // Sleeping workers count themselves before checking m_queued, so one of the two sides sees
+    // the other and no wake up is lost
+    m_queued++;
+    if (m_sleeping > 0) {
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_wake.notify_one();
+    }
+}
+
+Job* JobSystem::pop() {
+    size_t own = ownQueue();
+    {
+        JobQueue* queue = m_queues[own];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->jobs.empty()) {
+            Job* job = queue->jobs.back();
+            queue->jobs.pop_back();
+            m_queued--;
+            return job;
+        }
+    }
+
+    // Steal the oldest job, those tend to be the largest pieces of work
+    size_t count = m_queues.size();
+    size_t start = m_nextVictim++ % count;
+    for (size_t i = 0; i < count; i++) {
+        size_t victim = (start + i) % count;
+        if (victim == own) {
+            continue;
+        }
+        JobQueue* queue = m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->jobs.empty()) {
+            Job* job = queue->jobs.front();
+            queue->jobs.pop_front();
+            m_queued--;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job) {
+    job->fn();
+
+    JobCounter* counter = job->counter;
+    delete job;
+    if (!counter) {
+        return;
+    }
+
+    std::vector<Job*> released;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (--counter->m_count == 0) {
+            released.swap(counter->m_waiting);
+        }
+    }
+    // The counter may be gone from here on, the waiter can return as soon as the lock is free
+    for (Job* next : released) {
+        push(next);
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (!counter.isDone()) {
+        if (Job* job = pop()) {
+            execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (grain == 0) {
+        size_t ranges = (m_threads.size() + 1) * 4;
+        grain = std::max<size_t>(1, (count + ranges - 1) / ranges);
+    }
+    if (count <= grain) {
+        if (count > 0) {
+            fn(0, count);
+        }
+        return;
+    }
+
+    JobCounter done;
+    for (size_t begin = grain; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        run([&fn, begin, end]() { fn(begin, end); }, &done);
+    }
+    fn(0, grain);
+    wait(done);
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_pool = this;
+    t_queue = index;
+
+    while (true) {
+        if (Job* job = pop()) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleeping++;
+        m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+        m_sleeping--;
+        if (m_stop && m_queued == 0) {
+            return;
+        }
+    }
+}
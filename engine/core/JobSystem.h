@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+// Counts the unfinished jobs that were run with it. Jobs can be queued to start once a counter
+// is done (JobSystem::runAfter), which is how dependencies between jobs are expressed. Only
+// destroy a counter after waiting on it.
+class JobCounter {
+public:
+    JobCounter() : m_count(0) {}
+    ~JobCounter();
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const;
+
+private:
+    friend class JobSystem;
+
+    mutable std::mutex m_mutex;
+    int m_count;
+    // Jobs from runAfter, queued when the count drops to 0
+    std::vector<Job*> m_waiting;
+};
+
+// Work stealing thread pool. Every worker has its own deque, it runs its newest job first and
+// takes the oldest job of another queue when its own is empty. Threads that are not workers
+// share one more queue. A thread waiting on a counter runs jobs until the counter is done, so
+// waiting inside a job or on the main thread with no workers at all does not deadlock.
+//
+//   JobCounter built, compacted;
+//   jobs.run([&] { buildTree(); }, &built);
+//   jobs.runAfter(built, [&] { compactTree(); }, &compacted);
+//   jobs.parallelFor(rows, 4096, [&](size_t begin, size_t end) { ... });
+//   jobs.wait(compacted);
+class JobSystem {
+public:
+    // Negative uses one worker per core besides the calling thread
+    explicit JobSystem(int workerCount = -1);
+    // Finishes the queued jobs, jobs still waiting on a counter that never finishes are dropped
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int getWorkerCount() const { return (int)m_threads.size(); }
+
+    void run(const std::function<void()>& fn, JobCounter* counter = nullptr);
+    void runAfter(JobCounter& dependency, const std::function<void()>& fn, JobCounter* counter = nullptr);
+    // Runs queued jobs on this thread until the counter is done
+    void wait(JobCounter& counter);
+
+    // fn(begin, end) over [0, count), every range but the last is grain long and starts at a
+    // multiple of grain. 0 picks a grain that gives every thread a few ranges. Returns when all ran.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<Job*> jobs;
+    };
+
+    // One per worker, the last one is shared by all other threads
+    std::vector<JobQueue*> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<int> m_queued;
+    std::atomic<int> m_sleeping;
+    std::atomic<unsigned> m_nextVictim;
+    std::atomic<bool> m_stop;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    size_t ownQueue() const;
+    void push(Job* job);
+    Job* pop();
+    void execute(Job* job);
+    void workerLoop(size_t index);
+};
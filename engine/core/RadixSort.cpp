@@ -0,0 +1,54 @@
+#include "RadixSort.h"
+#include <cstring>
+#include <utility>
+
+void radixSort(uint64_t* keys, uint32_t* values, size_t count, FrameArena& arena) {
+    if (count < 2) {
+        return;
+    }
+
+    // Every digit histogram in one read of the keys
+    size_t counts[8][256] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (int digit = 0; digit < 8; digit++) {
+            counts[digit][(key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    uint64_t* keyScratch = static_cast<uint64_t*>(arena.allocate(count * sizeof(uint64_t), alignof(uint64_t)));
+    uint32_t* valueScratch = static_cast<uint32_t*>(arena.allocate(count * sizeof(uint32_t), alignof(uint32_t)));
+    uint64_t* keysIn = keys;
+    uint32_t* valuesIn = values;
+    uint64_t* keysOut = keyScratch;
+    uint32_t* valuesOut = valueScratch;
+
+    for (int digit = 0; digit < 8; digit++) {
+        size_t* digitCounts = counts[digit];
+        int shift = digit * 8;
+        if (digitCounts[(keysIn[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            offsets[bucket] = offset;
+            offset += digitCounts[bucket];
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t target = offsets[(keysIn[i] >> shift) & 0xFF]++;
+            keysOut[target] = keysIn[i];
+            valuesOut[target] = valuesIn[i];
+        }
+
+        std::swap(keysIn, keysOut);
+        std::swap(valuesIn, valuesOut);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffers
+    if (keysIn != keys) {
+        std::memcpy(keys, keysIn, count * sizeof(uint64_t));
+        std::memcpy(values, valuesIn, count * sizeof(uint32_t));
+    }
+}
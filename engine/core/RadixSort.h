@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "FrameArena.h"
+
+// Sorts keys ascending and moves values along with them, stable, LSD over 8 bit digits. A byte
+// that is the same in every key is skipped, so keys that only use a few bits cost few passes.
+// The result ends up in keys and values, the scratch buffers come from the arena.
+void radixSort(uint64_t* keys, uint32_t* values, size_t count, FrameArena& arena);
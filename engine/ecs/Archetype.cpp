@@ -0,0 +1,93 @@
+#include "Archetype.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+size_t alignUp(size_t offset, size_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+}
+
+Archetype::Archetype(ComponentMask mask) : m_mask(mask), m_capacity(0), m_count(0) {
+    std::fill(m_offsets, m_offsets + kMaxComponents, 0);
+    std::fill(m_sizes, m_sizes + kMaxComponents, 0);
+
+    size_t rowBytes = sizeof(EntityHandle);
+    for (ComponentId id = 0; id < (ComponentId)kMaxComponents; id++) {
+        if (has(id)) {
+            m_sizes[id] = ComponentRegistry::info(id).size;
+            rowBytes += m_sizes[id];
+        }
+    }
+
+    // Start from the unpadded fit and back off until the aligned columns fit in the chunk
+    for (m_capacity = (uint32_t)(kChunkBytes / rowBytes); m_capacity > 0; m_capacity--) {
+        size_t offset = sizeof(EntityHandle) * m_capacity;
+        for (ComponentId id = 0; id < (ComponentId)kMaxComponents; id++) {
+            if (has(id)) {
+                offset = alignUp(offset, std::max<size_t>(ComponentRegistry::info(id).align, 16));
+                m_offsets[id] = offset;
+                offset += m_sizes[id] * m_capacity;
+            }
+        }
+        if (offset <= kChunkBytes) {
+            break;
+        }
+    }
+
+    if (m_capacity == 0) {
+        std::cerr << "Archetype: one entity with these components does not fit in a " << kChunkBytes
+                  << " byte chunk\n";
+        std::abort();
+    }
+}
+
+Archetype::~Archetype() {
+    for (ComponentChunk* chunk : m_chunks) {
+        delete chunk;
+    }
+}
+
+uint32_t Archetype::chunkSize(size_t chunk) const {
+    size_t first = chunk * m_capacity;
+    if (first >= m_count) {
+        return 0;
+    }
+    return (uint32_t)std::min<size_t>(m_capacity, m_count - first);
+}
+
+size_t Archetype::add(EntityHandle entity) {
+    if (m_count == m_chunks.size() * m_capacity) {
+        m_chunks.push_back(new ComponentChunk());
+    }
+
+    size_t row = m_count++;
+    reinterpret_cast<EntityHandle*>(m_chunks[row / m_capacity]->data)[row % m_capacity] = entity;
+    return row;
+}
+
+EntityHandle Archetype::remove(size_t row) {
+    size_t last = m_count - 1;
+    EntityHandle moved;
+    if (row != last) {
+        for (ComponentId id = 0; id < (ComponentId)kMaxComponents; id++) {
+            if (has(id)) {
+                std::memcpy(component(row, id), component(last, id), m_sizes[id]);
+            }
+        }
+        moved = entityAt(last);
+        reinterpret_cast<EntityHandle*>(m_chunks[row / m_capacity]->data)[row % m_capacity] = moved;
+    }
+
+    m_count--;
+    // Keeps one spare chunk so an entity going back and forth does not allocate every time
+    if (m_chunks.size() > 1 && m_count <= (m_chunks.size() - 2) * m_capacity) {
+        delete m_chunks.back();
+        m_chunks.pop_back();
+    }
+    return moved;
+}
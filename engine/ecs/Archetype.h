@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Component.h"
+#include "../scene/EntityStorage.h"
+
+const size_t kChunkBytes = 16 * 1024;
+
+// One block of entities, every component of the archetype is a contiguous array inside it
+struct alignas(64) ComponentChunk {
+    unsigned char data[kChunkBytes];
+};
+
+// All entities with exactly the same set of components. Entities are packed densely over the
+// chunks, every chunk but the last is full and removal moves the last entity into the hole.
+class Archetype {
+public:
+    explicit Archetype(ComponentMask mask);
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    ComponentMask getMask() const { return m_mask; }
+    bool has(ComponentId id) const { return (m_mask >> id & 1) != 0; }
+    uint32_t getChunkCapacity() const { return m_capacity; }
+    size_t size() const { return m_count; }
+    size_t getChunkCount() const { return m_chunks.size(); }
+    // Entities in chunk i
+    uint32_t chunkSize(size_t chunk) const;
+
+    // Adds an entity with uninitialized components, returns its row
+    size_t add(EntityHandle entity);
+    // Removes the row, returns the entity that was moved into it or a null handle
+    EntityHandle remove(size_t row);
+
+    EntityHandle* entities(size_t chunk) { return reinterpret_cast<EntityHandle*>(m_chunks[chunk]->data); }
+    // Start of a component array in a chunk, the archetype has to have the component
+    void* column(size_t chunk, ComponentId id) { return m_chunks[chunk]->data + m_offsets[id]; }
+    void* component(size_t row, ComponentId id) {
+        return m_chunks[row / m_capacity]->data + m_offsets[id] + (row % m_capacity) * m_sizes[id];
+    }
+    EntityHandle entityAt(size_t row) const {
+        return reinterpret_cast<const EntityHandle*>(m_chunks[row / m_capacity]->data)[row % m_capacity];
+    }
+
+private:
+    ComponentMask m_mask;
+    uint32_t m_capacity;
+    size_t m_count;
+    size_t m_offsets[kMaxComponents];
+    size_t m_sizes[kMaxComponents];
+    std::vector<ComponentChunk*> m_chunks;
+};
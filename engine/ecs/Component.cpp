@@ -0,0 +1,30 @@
+#include "Component.h"
+#include <mutex>
+#include <iostream>
+#include <cstdlib>
+
+namespace {
+
+ComponentInfo s_infos[kMaxComponents];
+ComponentId s_count = 0;
+std::mutex s_mutex;
+
+}
+
+ComponentId ComponentRegistry::add(size_t size, size_t align) {
+    // First uses can happen on several threads at once
+    std::lock_guard<std::mutex> lock(s_mutex);
+    ComponentId id = s_count;
+    if (id >= (ComponentId)kMaxComponents) {
+        std::cerr << "ComponentRegistry: more than " << kMaxComponents << " component types\n";
+        std::abort();
+    }
+
+    s_infos[id] = {size, align};
+    s_count = id + 1;
+    return id;
+}
+
+const ComponentInfo& ComponentRegistry::info(ComponentId id) {
+    return s_infos[id];
+}
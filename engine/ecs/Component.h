@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// Components are plain data, they are moved between chunks with memcpy and never constructed
+// or destroyed one by one. Every type gets a small id the first time it is used.
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+
+const int kMaxComponents = 64;
+
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+};
+
+class ComponentRegistry {
+public:
+    // Ids are handed out in first use order, running out of them is a fatal error
+    static ComponentId add(size_t size, size_t align);
+    static const ComponentInfo& info(ComponentId id);
+};
+
+template <typename T>
+ComponentId componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "Components must be trivially copyable");
+    static const ComponentId id = ComponentRegistry::add(sizeof(T), alignof(T));
+    return id;
+}
+
+// True when no type is listed twice
+template <typename... Ts>
+struct DistinctTypes : std::true_type {};
+
+template <typename T, typename... Ts>
+struct DistinctTypes<T, Ts...>
+    : std::integral_constant<bool, !std::disjunction<std::is_same<T, Ts>...>::value && DistinctTypes<Ts...>::value> {};
+
+template <typename... Ts>
+ComponentMask componentMask() {
+    ComponentMask mask = 0;
+    ComponentId ids[] = {componentId<Ts>()..., 0};
+    for (size_t i = 0; i < sizeof...(Ts); i++) {
+        mask |= (ComponentMask)1 << ids[i];
+    }
+    return mask;
+}
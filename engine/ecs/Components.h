@@ -0,0 +1,23 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "World.h"
+#include "../scene/Box.h"
+#include "../scene/AABB.h"
+
+struct Transform {
+    glm::vec3 position;
+};
+
+// Full extent of the entity around its position
+struct Bounds {
+    glm::vec3 size;
+};
+
+// A box is the Transform + Bounds archetype
+inline EntityHandle createBox(World& world, const Box& box) {
+    return world.create(Transform{box.position}, Bounds{box.size});
+}
+
+inline AABB worldBounds(const Transform& transform, const Bounds& bounds) {
+    return AABB::fromCenterSize(transform.position, bounds.size);
+}
@@ -0,0 +1,109 @@
+#include "World.h"
+
+World::~World() {
+    clear();
+}
+
+void World::clear() {
+    for (Archetype* archetype : m_archetypes) {
+        delete archetype;
+    }
+    m_archetypes.clear();
+    m_archetypeLookup.clear();
+
+    // Generations keep counting so handles from before the clear stay stale
+    m_freeSlots.clear();
+    for (uint32_t i = (uint32_t)m_slots.size(); i > 0; i--) {
+        Slot& slot = m_slots[i - 1];
+        if (slot.archetype) {
+            slot.archetype = nullptr;
+            slot.generation = EntityHandle::nextGeneration(slot.generation);
+        }
+        m_freeSlots.push_back(i - 1);
+    }
+    m_count = 0;
+}
+
+Archetype* World::archetypeFor(ComponentMask mask) {
+    auto it = m_archetypeLookup.find(mask);
+    if (it != m_archetypeLookup.end()) {
+        return it->second;
+    }
+
+    Archetype* archetype = new Archetype(mask);
+    m_archetypes.push_back(archetype);
+    m_archetypeLookup[mask] = archetype;
+    return archetype;
+}
+
+EntityHandle World::allocate(Archetype* archetype) {
+    uint32_t index;
+    if (!m_freeSlots.empty()) {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        index = (uint32_t)m_slots.size();
+        m_slots.push_back({nullptr, 0, 1});
+    }
+
+    Slot& slot = m_slots[index];
+    EntityHandle entity(index, slot.generation);
+    slot.archetype = archetype;
+    slot.row = archetype->add(entity);
+    m_count++;
+    return entity;
+}
+
+const World::Slot* World::slotOf(EntityHandle entity) const {
+    if (entity.isNull() || entity.index >= m_slots.size()) {
+        return nullptr;
+    }
+    const Slot& slot = m_slots[entity.index];
+    if (!slot.archetype || slot.generation != entity.generation) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+bool World::isAlive(EntityHandle entity) const {
+    return slotOf(entity) != nullptr;
+}
+
+void World::removeRow(Archetype* archetype, size_t row) {
+    EntityHandle moved = archetype->remove(row);
+    if (!moved.isNull()) {
+        m_slots[moved.index].row = row;
+    }
+}
+
+bool World::destroy(EntityHandle entity) {
+    if (!slotOf(entity)) {
+        return false;
+    }
+
+    Slot& slot = m_slots[entity.index];
+    removeRow(slot.archetype, slot.row);
+    slot.archetype = nullptr;
+    slot.generation = EntityHandle::nextGeneration(slot.generation);
+    m_freeSlots.push_back(entity.index);
+    m_count--;
+    return true;
+}
+
+void World::moveTo(EntityHandle entity, ComponentMask mask) {
+    Slot& slot = m_slots[entity.index];
+    Archetype* from = slot.archetype;
+    Archetype* to = archetypeFor(mask);
+    size_t fromRow = slot.row;
+    size_t toRow = to->add(entity);
+
+    for (ComponentId id = 0; id < (ComponentId)kMaxComponents; id++) {
+        if (from->has(id) && to->has(id)) {
+            std::memcpy(to->component(toRow, id), from->component(fromRow, id), ComponentRegistry::info(id).size);
+        }
+    }
+
+    removeRow(from, fromRow);
+    slot.archetype = to;
+    slot.row = toRow;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <utility>
+#include "Archetype.h"
+#include "../core/JobSystem.h"
+
+// Entities made of any set of components, stored per archetype in 16 KB chunks so a query walks
+// plain arrays. Adding or removing a component moves the entity to another archetype, which
+// copies its row, so prefer setting up entities with all their components at once.
+//
+//   EntityHandle e = world.create(Transform{position}, Bounds{size});
+//   world.forEach<Transform, Velocity>([dt](Transform& t, Velocity& v) { t.position += v.value * dt; });
+//
+// Handles work like the scene's: stale handles of destroyed entities are detected.
+class World {
+public:
+    World() = default;
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // One value per component type, listing a type twice does not compile
+    template <typename... Ts>
+    EntityHandle create(const Ts&... components);
+    bool destroy(EntityHandle entity);
+    void clear();
+
+    bool isAlive(EntityHandle entity) const;
+    size_t size() const { return m_count; }
+
+    // nullptr when the entity is stale or does not have the component
+    template <typename T>
+    T* get(EntityHandle entity);
+    template <typename T>
+    bool has(EntityHandle entity) const;
+    // Sets the component, adding it first when the entity does not have it yet
+    template <typename T>
+    bool set(EntityHandle entity, const T& value);
+    template <typename T>
+    bool remove(EntityHandle entity);
+
+    // fn(Ts&...) for every entity that has at least these components
+    template <typename... Ts, typename F>
+    void forEach(F&& fn);
+    // fn(count, Ts*...) once per chunk with the component arrays of that chunk
+    template <typename... Ts, typename F>
+    void forEachChunk(F&& fn);
+    // Same as forEachChunk with the chunks split into jobs, fn runs concurrently and must only
+    // touch the arrays it is given
+    template <typename... Ts, typename F>
+    void forEachChunkParallel(JobSystem& jobs, F&& fn);
+
+    size_t getArchetypeCount() const { return m_archetypes.size(); }
+
+private:
+    struct Slot {
+        Archetype* archetype;
+        size_t row;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<Archetype*> m_archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_archetypeLookup;
+    size_t m_count = 0;
+
+    Archetype* archetypeFor(ComponentMask mask);
+    EntityHandle allocate(Archetype* archetype);
+    const Slot* slotOf(EntityHandle entity) const;
+    // Moves the entity's row to the archetype with the given mask, keeping shared components
+    void moveTo(EntityHandle entity, ComponentMask mask);
+    void removeRow(Archetype* archetype, size_t row);
+};
+
+template <typename... Ts>
+EntityHandle World::create(const Ts&... components) {
+    // The mask would merge a repeated type and its second value would overwrite the first
+    static_assert(DistinctTypes<Ts...>::value, "Each component type can only be given once");
+    EntityHandle entity = allocate(archetypeFor(componentMask<Ts...>()));
+    Slot& slot = m_slots[entity.index];
+    // Expands to one copy per component
+    int expand[] = {0, (std::memcpy(slot.archetype->component(slot.row, componentId<Ts>()), &components, sizeof(Ts)), 0)...};
+    (void)expand;
+    return entity;
+}
+
+template <typename T>
+T* World::get(EntityHandle entity) {
+    const Slot* slot = slotOf(entity);
+    ComponentId id = componentId<T>();
+    if (!slot || !slot->archetype->has(id)) {
+        return nullptr;
+    }
+    return static_cast<T*>(slot->archetype->component(slot->row, id));
+}
+
+template <typename T>
+bool World::has(EntityHandle entity) const {
+    const Slot* slot = slotOf(entity);
+    return slot && slot->archetype->has(componentId<T>());
+}
+
+template <typename T>
+bool World::set(EntityHandle entity, const T& value) {
+    const Slot* slot = slotOf(entity);
+    if (!slot) {
+        return false;
+    }
+
+    ComponentId id = componentId<T>();
+    if (!slot->archetype->has(id)) {
+        moveTo(entity, slot->archetype->getMask() | (ComponentMask)1 << id);
+    }
+    std::memcpy(get<T>(entity), &value, sizeof(T));
+    return true;
+}
+
+template <typename T>
+bool World::remove(EntityHandle entity) {
+    const Slot* slot = slotOf(entity);
+    ComponentId id = componentId<T>();
+    if (!slot || !slot->archetype->has(id)) {
+        return false;
+    }
+    moveTo(entity, slot->archetype->getMask() & ~((ComponentMask)1 << id));
+    return true;
+}
+
+template <typename... Ts, typename F>
+void World::forEachChunk(F&& fn) {
+    ComponentMask mask = componentMask<Ts...>();
+    for (Archetype* archetype : m_archetypes) {
+        if ((archetype->getMask() & mask) != mask) {
+            continue;
+        }
+        for (size_t chunk = 0; chunk < archetype->getChunkCount(); chunk++) {
+            if (archetype->chunkSize(chunk) == 0) {
+                continue;
+            }
+            fn((size_t)archetype->chunkSize(chunk), static_cast<Ts*>(archetype->column(chunk, componentId<Ts>()))...);
+        }
+    }
+}
+
+template <typename... Ts, typename F>
+void World::forEach(F&& fn) {
+    forEachChunk<Ts...>([&fn](size_t count, Ts*... columns) {
+        for (size_t i = 0; i < count; i++) {
+            fn(columns[i]...);
+        }
+    });
+}
+
+template <typename... Ts, typename F>
+void World::forEachChunkParallel(JobSystem& jobs, F&& fn) {
+    ComponentMask mask = componentMask<Ts...>();
+    std::vector<std::pair<Archetype*, size_t>> chunks;
+    for (Archetype* archetype : m_archetypes) {
+        if ((archetype->getMask() & mask) == mask) {
+            for (size_t chunk = 0; chunk < archetype->getChunkCount(); chunk++) {
+                if (archetype->chunkSize(chunk) > 0) {
+                    chunks.push_back({archetype, chunk});
+                }
+            }
+        }
+    }
+
+    jobs.parallelFor(chunks.size(), 0, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Archetype* archetype = chunks[i].first;
+            size_t chunk = chunks[i].second;
+            fn((size_t)archetype->chunkSize(chunk), static_cast<Ts*>(archetype->column(chunk, componentId<Ts>()))...);
+        }
+    });
+}
@@ -1,63 +1,320 @@
 #include "BatchRenderer.h"
-#include <glm/gtc/matrix_transform.hpp>
+#include "../core/RadixSort.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 
-BatchRenderer::BatchRenderer() : m_maxInstances(1000) {
-    setupBuffers();
+namespace {
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Unit box with the faces of drawBoxGeometry, position and normal per vertex
+const float kBoxVertices[24][6] = {
+    {-0.5f, -0.5f, 0.5f, 0, 0, 1}, {0.5f, -0.5f, 0.5f, 0, 0, 1}, {0.5f, 0.5f, 0.5f, 0, 0, 1}, {-0.5f, 0.5f, 0.5f, 0, 0, 1},
+    {-0.5f, -0.5f, -0.5f, 0, 0, -1}, {-0.5f, 0.5f, -0.5f, 0, 0, -1}, {0.5f, 0.5f, -0.5f, 0, 0, -1}, {0.5f, -0.5f, -0.5f, 0, 0, -1},
+    {-0.5f, -0.5f, -0.5f, -1, 0, 0}, {-0.5f, -0.5f, 0.5f, -1, 0, 0}, {-0.5f, 0.5f, 0.5f, -1, 0, 0}, {-0.5f, 0.5f, -0.5f, -1, 0, 0},
+    {0.5f, -0.5f, -0.5f, 1, 0, 0}, {0.5f, 0.5f, -0.5f, 1, 0, 0}, {0.5f, 0.5f, 0.5f, 1, 0, 0}, {0.5f, -0.5f, 0.5f, 1, 0, 0},
+    {-0.5f, 0.5f, -0.5f, 0, 1, 0}, {-0.5f, 0.5f, 0.5f, 0, 1, 0}, {0.5f, 0.5f, 0.5f, 0, 1, 0}, {0.5f, 0.5f, -0.5f, 0, 1, 0},
+    {-0.5f, -0.5f, -0.5f, 0, -1, 0}, {0.5f, -0.5f, -0.5f, 0, -1, 0}, {0.5f, -0.5f, 0.5f, 0, -1, 0}, {-0.5f, -0.5f, 0.5f, 0, -1, 0}
+};
+
+const GLuint kPositionAttribute = 0;
+const GLuint kNormalAttribute = 1;
+// A mat4 takes four attributes, one per column
+const GLuint kInstanceAttribute = 2;
+
+// Lights like the fixed function pipeline with GL_COLOR_MATERIAL, reading the light and material
+// that Renderer::setupState set. Instance matrices only translate and scale, so dividing the
+// normal by the scale is enough to transform it.
+const char* kVertexShader = R"(
+#version 120
+attribute vec3 position;
+attribute vec3 normal;
+attribute mat4 instanceMatrix;
+varying vec4 color;
+
+void main() {
+    vec4 eyePosition = gl_ModelViewMatrix * (instanceMatrix * vec4(position, 1.0));
+    vec3 scale = vec3(length(instanceMatrix[0].xyz), length(instanceMatrix[1].xyz), length(instanceMatrix[2].xyz));
+    vec3 eyeNormal = normalize(gl_NormalMatrix * (normal / scale));
+
+    vec4 light = gl_LightSource[0].position;
+    vec3 toLight = normalize(light.w == 0.0 ? light.xyz : light.xyz - eyePosition.xyz);
+    float diffuse = max(dot(eyeNormal, toLight), 0.0);
+    float specular = 0.0;
+    if (diffuse > 0.0) {
+        vec3 halfVector = normalize(toLight + vec3(0.0, 0.0, 1.0));
+        specular = pow(max(dot(eyeNormal, halfVector), 0.0), gl_FrontMaterial.shininess);
+    }
+
+    color = gl_LightModel.ambient * gl_Color + gl_LightSource[0].ambient * gl_Color +
+            gl_LightSource[0].diffuse * gl_Color * diffuse +
+            gl_LightSource[0].specular * gl_FrontMaterial.specular * specular;
+    color.a = gl_Color.a;
+    gl_Position = gl_ProjectionMatrix * eyePosition;
+}
+)";
+
+const char* kFragmentShader = R"(
+#version 120
+varying vec4 color;
+
+void main() {
+    gl_FragColor = color;
+}
+)";
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[1024] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Batch shader failed to compile: " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+}
+
+BatchRenderer::BatchRenderer()
+    : m_vao(0), m_vbo(0), m_ibo(0), m_instanceVBO(0), m_indirectBuffer(0), m_program(0),
+      m_instanceCapacity(0), m_lodMeshes(),
+      m_bestPath(BatchPath::Immediate), m_path(BatchPath::Immediate) {
+    if (GLEW_VERSION_3_3 && setupProgram()) {
+        setupBuffers();
+        m_bestPath = BatchPath::Instanced;
+        // baseInstance offsets the instance attributes only with 4.2 or ARB_base_instance
+        if (GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance)) {
+            m_bestPath = BatchPath::MultiDrawIndirect;
+        }
+    }
+    m_path = m_bestPath;
 }
 
 BatchRenderer::~BatchRenderer() {
     glDeleteVertexArrays(1, &m_vao);
     glDeleteBuffers(1, &m_vbo);
+    glDeleteBuffers(1, &m_ibo);
     glDeleteBuffers(1, &m_instanceVBO);
+    glDeleteBuffers(1, &m_indirectBuffer);
+    glDeleteProgram(m_program);
+}
+
+void BatchRenderer::setPath(BatchPath path) {
+    m_path = path < m_bestPath ? m_bestPath : path;
+}
+
+const char* BatchRenderer::getPathName(BatchPath path) {
+    switch (path) {
+        case BatchPath::MultiDrawIndirect: return "multi draw indirect";
+        case BatchPath::Instanced:         return "instanced";
+        default:                           return "immediate";
+    }
+}
+
+bool BatchRenderer::setupProgram() {
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (!vertex || !fragment) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return false;
+    }
+
+    m_program = glCreateProgram();
+    glAttachShader(m_program, vertex);
+    glAttachShader(m_program, fragment);
+    glBindAttribLocation(m_program, kPositionAttribute, "position");
+    glBindAttribLocation(m_program, kNormalAttribute, "normal");
+    glBindAttribLocation(m_program, kInstanceAttribute, "instanceMatrix");
+    glLinkProgram(m_program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024] = {};
+        glGetProgramInfoLog(m_program, sizeof(log), nullptr, log);
+        std::cerr << "Batch shader failed to link: " << log << std::endl;
+        glDeleteProgram(m_program);
+        m_program = 0;
+        return false;
+    }
+    return true;
 }
 
 void BatchRenderer::setupBuffers() {
-   // In a real implementation, you'd set up VBOs and instance buffers here
+    // Two triangles per face of the box
+    GLushort indices[36];
+    for (GLushort face = 0; face < 6; face++) {
+        const GLushort quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; i++) {
+            indices[face * 6 + i] = (GLushort)(face * 4 + quad[i]);
+        }
+    }
+    for (MeshRange& mesh : m_lodMeshes) {
+        mesh = {0, 36, 0};
+    }
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ibo);
+    glGenBuffers(1, &m_instanceVBO);
+    glGenBuffers(1, &m_indirectBuffer);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kBoxVertices), kBoxVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(kPositionAttribute);
+    glVertexAttribPointer(kPositionAttribute, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (const void*)0);
+    glEnableVertexAttribArray(kNormalAttribute);
+    glVertexAttribPointer(kNormalAttribute, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (const void*)(3 * sizeof(float)));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    for (GLuint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(kInstanceAttribute + column);
+        glVertexAttribDivisor(kInstanceAttribute + column, 1);
+    }
+    pointInstanceAttributes(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void BatchRenderer::beginBatch() {
-    m_instances.clear();
+uint64_t BatchRenderer::makeSortKey(LODLevel lod, uint32_t mesh, uint32_t material, float depth) {
+    // NaN and negative depths (behind the eye) go to the front of their group
+    if (!(depth > 0.0f)) {
+        depth = 0.0f;
+    }
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return ((uint64_t)lod & 0xF) << 60 |
+           ((uint64_t)mesh & 0x3FFF) << 46 |
+           ((uint64_t)material & 0x3FFF) << 32 |
+           depthBits;
 }
 
-void BatchRenderer::addInstance(const Box* box, LODLevel lod, const glm::vec3& cameraPos) {
-    if (lod == LODLevel::CULLED) return;
+void BatchRenderer::sortInstances(const std::vector<InstanceData>& instances, const glm::mat4& view,
+                                  FrameVector<uint64_t>& keys, FrameVector<uint32_t>& order, FrameArena& arena) {
+    keys.clear();
+    order.clear();
+    keys.reserve(instances.size());
+    order.reserve(instances.size());
 
-    InstanceData data;
-    data.modelMatrix = glm::translate(glm::mat4(1.0f), box->position);
-    data.modelMatrix = glm::scale(data.modelMatrix, box->size);
-    data.lodLevel = static_cast<int>(lod);
+    // Only the z row of the view matrix is needed for the depth of the instance origin
+    glm::vec4 depthRow(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+    for (size_t i = 0; i < instances.size(); i++) {
+        const InstanceData& instance = instances[i];
+        if (instance.lodLevel < 0 || instance.lodLevel >= static_cast<int>(LODLevel::CULLED)) {
+            continue;
+        }
+        const glm::vec4& origin = instance.modelMatrix[3];
+        float depth = depthRow.x * origin.x + depthRow.y * origin.y + depthRow.z * origin.z + depthRow.w * origin.w;
+        keys.push_back(makeSortKey(static_cast<LODLevel>(instance.lodLevel), 0, 0, depth));
+        order.push_back((uint32_t)i);
+    }
 
-    m_instances.push_back(data);
+    radixSort(keys.data(), order.data(), keys.size(), arena);
 }
 
-void BatchRenderer::endBatch() {
-    flush();
+void BatchRenderer::draw(const std::vector<InstanceData>& instances, const glm::mat4& view, FrameArena& arena) {
+    FrameVector<uint64_t> keys{FrameAllocator<uint64_t>(arena)};
+    FrameVector<uint32_t> order{FrameAllocator<uint32_t>(arena)};
+    sortInstances(instances, view, keys, order, arena);
+
+    if (m_path != BatchPath::Immediate) {
+        drawIndirect(keys.data(), order.data(), keys.size(), instances, arena);
+        return;
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        glPushMatrix();
+        glMultMatrixf(&instances[order[i]].modelMatrix[0][0]);
+        drawBoxGeometry(getSortKeyLOD(keys[i]));
+        glPopMatrix();
+    }
 }
 
-void BatchRenderer::flush() {
-    std::vector<InstanceData> highLOD, mediumLOD, lowLOD;
+void BatchRenderer::drawIndirect(const uint64_t* keys, const uint32_t* order, size_t count,
+                                 const std::vector<InstanceData>& instances, FrameArena& arena) {
+    if (count == 0) {
+        return;
+    }
 
-    for (const auto& instance : m_instances) {
-        switch (static_cast<LODLevel>(instance.lodLevel)) {
-            case LODLevel::HIGH:   highLOD.push_back(instance); break;
-            case LODLevel::MEDIUM: mediumLOD.push_back(instance); break;
-            case LODLevel::LOW:    lowLOD.push_back(instance); break;
-            default: break;
+    // Matrices go in sorted order, so every run of keys with the same state is one range of
+    // instances. Reallocating the store every frame lets the driver hand out fresh memory while
+    // the last frame may still read the old one.
+    m_instanceCapacity = std::max(m_instanceCapacity, count);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glm::mat4* matrices = static_cast<glm::mat4*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4),
+                                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!matrices) {
+        std::cerr << "Failed to map the instance buffer" << std::endl;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        matrices[i] = instances[order[i]].modelMatrix;
+    }
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+
+    FrameVector<DrawElementsIndirectCommand> commands{FrameAllocator<DrawElementsIndirectCommand>(arena)};
+    size_t start = 0;
+    for (size_t i = 1; i <= count; i++) {
+        if (i < count && (keys[i] >> 32) == (keys[start] >> 32)) {
+            continue;
         }
+        const MeshRange& mesh = m_lodMeshes[static_cast<int>(getSortKeyLOD(keys[start]))];
+        commands.push_back({mesh.indexCount, (GLuint)(i - start), mesh.firstIndex, mesh.baseVertex, (GLuint)start});
+        start = i;
     }
 
-    auto renderGroup = [this](const std::vector<InstanceData>& group, LODLevel lod) {
-        for (const auto& instance : group) {
-            glPushMatrix();
-            glMultMatrixf(&instance.modelMatrix[0][0]);
-            drawBoxGeometry(lod);
-            glPopMatrix();
+    glUseProgram(m_program);
+    glBindVertexArray(m_vao);
+    if (m_path == BatchPath::MultiDrawIndirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, (GLsizei)commands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        // Without baseInstance the instance attributes start at the group instead
+        for (const DrawElementsIndirectCommand& command : commands) {
+            pointInstanceAttributes(command.baseInstance);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_SHORT,
+                                              (const void*)(command.firstIndex * sizeof(GLushort)),
+                                              command.instanceCount, command.baseVertex);
         }
-    };
+        pointInstanceAttributes(0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
 
-    renderGroup(highLOD, LODLevel::HIGH);
-    renderGroup(mediumLOD, LODLevel::MEDIUM);
-    renderGroup(lowLOD, LODLevel::LOW);
+void BatchRenderer::pointInstanceAttributes(size_t firstInstance) {
+    // Reads GL_ARRAY_BUFFER, which has to be the instance buffer
+    for (GLuint column = 0; column < 4; column++) {
+        glVertexAttribPointer(kInstanceAttribute + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (const void*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+    }
 }
 
 void BatchRenderer::drawBoxGeometry(LODLevel lod) {
@@ -1,30 +1,70 @@
 #pragma once
 #include <GL/glew.h>
 #include <vector>
+#include <cstdint>
 #include <glm/glm.hpp>
-#include "../scene/Box.h"
 #include "../systems/LODSystem.h"
+#include "RenderPacket.h"
+#include "../core/FrameArena.h"
 
-struct InstanceData {
-    glm::mat4 modelMatrix;
-    int lodLevel;
+// How the sorted instances reach the GPU, the constructor picks the first the context supports
+enum class BatchPath {
+    // One glMultiDrawElementsIndirect for everything, GL 4.3 or ARB_multi_draw_indirect
+    MultiDrawIndirect,
+    // The same commands as one instanced draw each, GL 3.3
+    Instanced,
+    // A fixed function box per instance
+    Immediate
 };
 
 class BatchRenderer {
 public:
+    // Needs the GL context current
     BatchRenderer();
     ~BatchRenderer();
 
-    void beginBatch();
-    void addInstance(const Box* box, LODLevel lod, const glm::vec3& cameraPos);
-    void endBatch();
-    void flush();
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // Paths the context doesn't support fall back to the next one
+    void setPath(BatchPath path);
+    BatchPath getPath() const { return m_path; }
+    static const char* getPathName(BatchPath path);
+
+    // Draws the instances sorted by their sort key, on the thread that owns the GL context. The
+    // keys live in the arena, which belongs to the drawing thread.
+    void draw(const std::vector<InstanceData>& instances, const glm::mat4& view, FrameArena& arena);
+
+    // State first so instances that draw alike end up next to each other, then view depth so
+    // every group goes front to back and hidden pixels fail the depth test early.
+    //   63..60 LOD | 59..46 mesh | 45..32 material | 31..0 depth
+    // Depth is the float bit pattern, for depths of 0 and up it sorts the same as the float.
+    static uint64_t makeSortKey(LODLevel lod, uint32_t mesh, uint32_t material, float depth);
+    static LODLevel getSortKeyLOD(uint64_t key) { return static_cast<LODLevel>(key >> 60); }
+    // Sort keys of the instances that aren't culled, sorted, and the instance index of every key.
+    // Makes no GL calls.
+    static void sortInstances(const std::vector<InstanceData>& instances, const glm::mat4& view,
+                              FrameVector<uint64_t>& keys, FrameVector<uint32_t>& order, FrameArena& arena);
 
 private:
-    std::vector<InstanceData> m_instances;
-    GLuint m_vao, m_vbo, m_instanceVBO;
-    int m_maxInstances;
+    // Where a mesh sits in the shared vertex and index buffers
+    struct MeshRange {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLint baseVertex;
+    };
+
+    GLuint m_vao, m_vbo, m_ibo, m_instanceVBO, m_indirectBuffer, m_program;
+    size_t m_instanceCapacity;
+    // Indexed by LOD, every LOD is the same box for now
+    MeshRange m_lodMeshes[3];
+    BatchPath m_bestPath;
+    BatchPath m_path;
 
     void setupBuffers();
+    bool setupProgram();
+    void drawIndirect(const uint64_t* keys, const uint32_t* order, size_t count,
+                      const std::vector<InstanceData>& instances, FrameArena& arena);
+    void pointInstanceAttributes(size_t firstInstance);
     void drawBoxGeometry(LODLevel lod);
 };
\ No newline at end of file
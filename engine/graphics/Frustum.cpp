@@ -67,6 +67,21 @@ bool Frustum::isBoxVisible(const Box* box) const {
     return true;
 }
 
+bool Frustum::isAABBVisible(const glm::vec3& min, const glm::vec3& max) const {
+    for (int i = 0; i < COUNT; i++) {
+        glm::vec3 positiveVertex;
+        positiveVertex.x = (m_planes[i].normal.x >= 0) ? max.x : min.x;
+        positiveVertex.y = (m_planes[i].normal.y >= 0) ? max.y : min.y;
+        positiveVertex.z = (m_planes[i].normal.z >= 0) ? max.z : min.z;
+
+        if (m_planes[i].distanceToPoint(positiveVertex) < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool Frustum::isSphereVisible(const glm::vec3& center, float radius) const {
     for (int i = 0; i < COUNT; i++) {
         if (m_planes[i].distanceToPoint(center) < -radius) {
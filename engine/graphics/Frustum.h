@@ -2,6 +2,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "../scene/Box.h"
+#include "../scene/AABB.h"
 
 struct Plane {
     glm::vec3 normal;
@@ -22,6 +23,8 @@ public:
 
     void update(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix);
     bool isBoxVisible(const Box* box) const;
+    bool isAABBVisible(const glm::vec3& min, const glm::vec3& max) const;
+    bool isAABBVisible(const AABB& bounds) const { return isAABBVisible(bounds.min, bounds.max); }
     bool isSphereVisible(const glm::vec3& center, float radius) const;
 
 private:
@@ -0,0 +1,101 @@
+#include "MeshCache.h"
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+const int kFloatsPerVertex = 6;
+
+std::atomic<uint64_t> s_nextId(1);
+std::mutex s_releaseMutex;
+std::vector<uint64_t> s_released;
+
+}
+
+MeshCache::~MeshCache() {
+    for (auto& entry : m_buffers) {
+        glDeleteBuffers(1, &entry.second);
+    }
+}
+
+uint64_t MeshCache::createId() {
+    return s_nextId++;
+}
+
+void MeshCache::release(uint64_t mesh) {
+    if (mesh == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_releaseMutex);
+    s_released.push_back(mesh);
+}
+
+void MeshCache::takeReleased(std::vector<uint64_t>& releases) {
+    std::lock_guard<std::mutex> lock(s_releaseMutex);
+    releases.insert(releases.end(), s_released.begin(), s_released.end());
+    s_released.clear();
+}
+
+void MeshCache::upload(const MeshUpload& upload) {
+    GLuint& buffer = m_buffers[upload.mesh];
+    if (!buffer) {
+        glGenBuffers(1, &buffer);
+    }
+
+    if (!upload.indices.empty()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, upload.indices.size() * sizeof(GLushort), upload.indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, upload.vertices.size() * sizeof(float), upload.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void MeshCache::draw(const MeshDraw& draw) {
+    auto vertices = m_buffers.find(draw.mesh);
+    if (vertices == m_buffers.end() || draw.count == 0) {
+        return;
+    }
+
+    if (!m_drawing) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        m_drawing = true;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertices->second);
+    glVertexPointer(3, GL_FLOAT, kFloatsPerVertex * sizeof(float), (const void*)0);
+    glNormalPointer(GL_FLOAT, kFloatsPerVertex * sizeof(float), (const void*)(3 * sizeof(float)));
+
+    if (draw.indexMesh == 0) {
+        glDrawArrays(draw.primitive, 0, draw.count);
+        return;
+    }
+    auto indices = m_buffers.find(draw.indexMesh);
+    if (indices != m_buffers.end()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices->second);
+        glDrawElements(draw.primitive, draw.count, GL_UNSIGNED_SHORT, (const void*)0);
+    }
+}
+
+void MeshCache::end() {
+    if (m_drawing) {
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        m_drawing = false;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void MeshCache::free(const std::vector<uint64_t>& meshes) {
+    for (uint64_t mesh : meshes) {
+        auto it = m_buffers.find(mesh);
+        if (it != m_buffers.end()) {
+            glDeleteBuffers(1, &it->second);
+            m_buffers.erase(it);
+        }
+    }
+}
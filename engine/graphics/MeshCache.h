@@ -0,0 +1,36 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "RenderPacket.h"
+
+// GL buffers of the meshes in render packets, owned by the thread that draws. Mesh ids come from
+// createId() and are never reused, so the code that builds a mesh never needs the GL context:
+// it hands out an id, sends the vertices with a packet and releases the id when done.
+class MeshCache {
+public:
+    MeshCache() = default;
+    ~MeshCache();
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    // Both can be called from any thread
+    static uint64_t createId();
+    static void release(uint64_t mesh);
+    // Moves the ids released since the last call to the end of releases
+    static void takeReleased(std::vector<uint64_t>& releases);
+
+    void upload(const MeshUpload& upload);
+    // Vertex and normal arrays stay enabled for a run of draws, end() turns them off
+    void draw(const MeshDraw& draw);
+    void end();
+    void free(const std::vector<uint64_t>& meshes);
+
+    size_t getMeshCount() const { return m_buffers.size(); }
+
+private:
+    std::unordered_map<uint64_t, GLuint> m_buffers;
+    bool m_drawing = false;
+};
@@ -0,0 +1,26 @@
+#include "NullBackend.h"
+
+NullBackend::NullBackend() : m_width(0), m_height(0), m_frames(0) {}
+
+bool NullBackend::initialize(int width, int height, const char*) {
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void NullBackend::submit(const RenderPacket& packet, FrameArena&) {
+    m_lastFrame.boxes = packet.boxes.size();
+    m_lastFrame.meshes = packet.meshes.size();
+    m_lastFrame.instances = packet.instances.size();
+    m_lastFrame.uploads = packet.uploads.size();
+
+    m_total.boxes += m_lastFrame.boxes;
+    m_total.meshes += m_lastFrame.meshes;
+    m_total.instances += m_lastFrame.instances;
+    m_total.uploads += m_lastFrame.uploads;
+}
+
+void NullBackend::getFramebufferSize(int& width, int& height) {
+    width = m_width;
+    height = m_height;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "RenderBackend.h"
+#include <cstdint>
+
+struct DrawCounts {
+    uint64_t boxes = 0;
+    uint64_t meshes = 0;
+    uint64_t instances = 0;
+    uint64_t uploads = 0;
+};
+
+// Makes no GL calls, submit() only counts what the packet asks for. Lets culling, LOD and
+// batching run and be timed on machines without any display or GL.
+class NullBackend : public RenderBackend {
+public:
+    NullBackend();
+
+    bool initialize(int width, int height, const char* title) override;
+
+    void makeCurrent(bool) override {}
+    void setupState(int, int) override {}
+    void submit(const RenderPacket& packet, FrameArena& arena) override;
+    void present() override { m_frames++; }
+
+    void getFramebufferSize(int& width, int& height) override;
+
+    // Written by the drawing thread, read them after run() returns or with the render thread off
+    const DrawCounts& getLastFrame() const { return m_lastFrame; }
+    const DrawCounts& getTotal() const { return m_total; }
+    uint64_t getFrameCount() const { return m_frames; }
+
+private:
+    int m_width, m_height;
+    DrawCounts m_lastFrame;
+    DrawCounts m_total;
+    uint64_t m_frames;
+};
@@ -0,0 +1,123 @@
+#include <GL/glew.h>
+#include "OffscreenBackend.h"
+#include "Renderer.h"
+#include <iostream>
+
+#ifdef ENGINE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+OffscreenBackend::OffscreenBackend()
+    : m_width(0), m_height(0), m_display(nullptr), m_surface(nullptr), m_context(nullptr), m_renderer(nullptr) {}
+
+#ifdef ENGINE_HAS_EGL
+
+OffscreenBackend::~OffscreenBackend() {
+    delete m_renderer;
+    if (m_display) {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_context) {
+            eglDestroyContext(m_display, m_context);
+        }
+        if (m_surface) {
+            eglDestroySurface(m_display, m_surface);
+        }
+        eglTerminate(m_display);
+    }
+}
+
+bool OffscreenBackend::initialize(int width, int height, const char*) {
+    m_width = width;
+    m_height = height;
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cerr << "Failed to init EGL\n";
+        return false;
+    }
+    m_display = display;
+
+    // The renderer uses the fixed function pipeline, so a desktop GL compatibility context
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount < 1) {
+        std::cerr << "No EGL config for offscreen GL rendering\n";
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    m_surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (m_surface == EGL_NO_SURFACE) {
+        std::cerr << "Failed to create EGL pbuffer\n";
+        m_surface = nullptr;
+        return false;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+    m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if (m_context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context\n";
+        m_context = nullptr;
+        return false;
+    }
+    if (!eglMakeCurrent(display, m_surface, m_surface, m_context)) {
+        std::cerr << "Failed to make the EGL context current\n";
+        return false;
+    }
+
+    m_renderer = createRenderer();
+    return m_renderer != nullptr;
+}
+
+void OffscreenBackend::makeCurrent(bool current) {
+    if (current) {
+        eglMakeCurrent(m_display, m_surface, m_surface, m_context);
+    } else {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+}
+
+#else
+
+OffscreenBackend::~OffscreenBackend() {}
+
+bool OffscreenBackend::initialize(int, int, const char*) {
+    std::cerr << "Offscreen rendering needs EGL, this build has none\n";
+    return false;
+}
+
+void OffscreenBackend::makeCurrent(bool) {}
+
+#endif
+
+void OffscreenBackend::setupState(int width, int height) {
+    m_renderer->setupState(width, height);
+}
+
+void OffscreenBackend::submit(const RenderPacket& packet, FrameArena& arena) {
+    m_renderer->submit(packet, arena);
+}
+
+void OffscreenBackend::present() {
+    glFinish();
+}
+
+void OffscreenBackend::getFramebufferSize(int& width, int& height) {
+    width = m_width;
+    height = m_height;
+}
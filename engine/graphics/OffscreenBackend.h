@@ -0,0 +1,31 @@
+#pragma once
+#include "RenderBackend.h"
+
+// Draws into an EGL pbuffer, no display or window system needed. Prefers Mesa's surfaceless
+// platform, so it also runs on machines without X or a GPU. Only builds with ENGINE_HAS_EGL,
+// otherwise initialize() fails.
+class OffscreenBackend : public RenderBackend {
+public:
+    OffscreenBackend();
+    ~OffscreenBackend() override;
+
+    bool initialize(int width, int height, const char* title) override;
+
+    void makeCurrent(bool current) override;
+    void setupState(int width, int height) override;
+    void submit(const RenderPacket& packet, FrameArena& arena) override;
+    // Nothing to show, waits for the GPU so frame times include the drawing
+    void present() override;
+
+    void getFramebufferSize(int& width, int& height) override;
+
+    Renderer* getRenderer() override { return m_renderer; }
+
+private:
+    int m_width, m_height;
+    // EGLDisplay, EGLSurface and EGLContext, opaque so this header needs no EGL
+    void* m_display;
+    void* m_surface;
+    void* m_context;
+    Renderer* m_renderer;
+};
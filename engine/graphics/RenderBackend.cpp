@@ -0,0 +1,58 @@
+#include <GL/glew.h>
+#include "RenderBackend.h"
+#include "Renderer.h"
+#include "WindowBackend.h"
+#include "OffscreenBackend.h"
+#include "NullBackend.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+double steadySeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+RenderBackend::RenderBackend() : m_startTime(steadySeconds()) {}
+
+RenderBackend* RenderBackend::create(RenderBackendType type) {
+    switch (type) {
+        case RenderBackendType::Offscreen: return new OffscreenBackend();
+        case RenderBackendType::Null:      return new NullBackend();
+        default:                           return new WindowBackend();
+    }
+}
+
+const char* RenderBackend::getTypeName(RenderBackendType type) {
+    switch (type) {
+        case RenderBackendType::Offscreen: return "offscreen";
+        case RenderBackendType::Null:      return "null";
+        default:                           return "window";
+    }
+}
+
+double RenderBackend::getTime() {
+    return steadySeconds() - m_startTime;
+}
+
+Renderer* RenderBackend::createRenderer() {
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX finds no X display under EGL, the GL entry points load all the same
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY) {
+        status = glewContextInit();
+    }
+#endif
+    if (status != GLEW_OK) {
+        std::cerr << "Failed to init GLEW\n";
+        return nullptr;
+    }
+
+    std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
+
+    Renderer* renderer = new Renderer();
+    std::cout << "Batch path: " << BatchRenderer::getPathName(renderer->getBatchRenderer()->getPath()) << std::endl;
+    return renderer;
+}
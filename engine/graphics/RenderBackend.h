@@ -0,0 +1,58 @@
+#pragma once
+#include "RenderPacket.h"
+#include "../core/FrameArena.h"
+
+struct GLFWwindow;
+class Renderer;
+
+enum class RenderBackendType {
+    Window,     // GLFW window, what the app uses
+    Offscreen,  // GL context without a display, through EGL
+    Null        // No GL at all, only counts what would be drawn
+};
+
+// Where Application sends its frames. initialize() and the main thread functions run on the
+// thread that made the backend, the drawing ones on whichever thread has the context.
+class RenderBackend {
+public:
+    RenderBackend();
+    virtual ~RenderBackend() = default;
+
+    RenderBackend(const RenderBackend&) = delete;
+    RenderBackend& operator=(const RenderBackend&) = delete;
+
+    static RenderBackend* create(RenderBackendType type);
+    static const char* getTypeName(RenderBackendType type);
+
+    // Opens the window or context, prints the reason and returns false when it can't.
+    // On success the context is current on the calling thread.
+    virtual bool initialize(int width, int height, const char* title) = 0;
+
+    // Drawing thread
+    virtual void makeCurrent(bool current) = 0;
+    virtual void setupState(int width, int height) = 0;
+    virtual void submit(const RenderPacket& packet, FrameArena& arena) = 0;
+    virtual void present() = 0;
+
+    // Main thread
+    virtual bool shouldClose() { return false; }
+    virtual void pollEvents() {}
+    // Seconds since the backend was made
+    virtual double getTime();
+    virtual void getFramebufferSize(int& width, int& height) = 0;
+    // Waits for the display on present(), taking effect when setupState() runs next. Backends
+    // without a display never wait.
+    virtual void setVsync(bool) {}
+
+    // nullptr for backends without them
+    virtual GLFWwindow* getWindow() { return nullptr; }
+    virtual Renderer* getRenderer() { return nullptr; }
+
+protected:
+    // Loads the GL entry points for the current context and makes the renderer, nullptr if
+    // GLEW fails
+    static Renderer* createRenderer();
+
+private:
+    double m_startTime;
+};
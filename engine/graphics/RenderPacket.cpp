@@ -0,0 +1,29 @@
+#include "RenderPacket.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+void RenderPacket::clear() {
+    view = glm::mat4(1.0f);
+    projection = glm::mat4(1.0f);
+    boxes.clear();
+    instances.clear();
+    uploads.clear();
+    meshes.clear();
+    releases.clear();
+}
+
+MeshUpload& RenderPacket::addUpload(uint64_t mesh) {
+    uploads.emplace_back();
+    uploads.back().mesh = mesh;
+    return uploads.back();
+}
+
+void RenderPacket::addInstance(const glm::vec3& position, const glm::vec3& size, LODLevel lod) {
+    if (lod == LODLevel::CULLED) return;
+
+    InstanceData data;
+    data.modelMatrix = glm::translate(glm::mat4(1.0f), position);
+    data.modelMatrix = glm::scale(data.modelMatrix, size);
+    data.lodLevel = static_cast<int>(lod);
+
+    instances.push_back(data);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../systems/LODSystem.h"
+
+struct InstanceData {
+    glm::mat4 modelMatrix;
+    int lodLevel;
+};
+
+struct BoxDraw {
+    glm::vec3 position;
+    glm::vec3 size;
+};
+
+// New contents of a mesh buffer, position and normal per vertex. Uploads with indices fill an
+// index buffer instead. A mesh uploaded again replaces its old contents.
+struct MeshUpload {
+    uint64_t mesh;
+    std::vector<float> vertices;
+    std::vector<GLushort> indices;
+};
+
+// Draws count vertices of a mesh, through the index mesh when it is not 0
+struct MeshDraw {
+    uint64_t mesh;
+    uint64_t indexMesh;
+    GLenum primitive;
+    int count;
+};
+
+// Everything needed to draw one frame, built by the scene without touching GL so the render
+// thread can draw one packet while the next one is built. Meshes are referred to by MeshCache ids.
+struct RenderPacket {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+
+    // Boxes drawn one by one when batch rendering is off
+    std::vector<BoxDraw> boxes;
+    std::vector<InstanceData> instances;
+    // Uploads go before the draws and releases after them
+    std::vector<MeshUpload> uploads;
+    std::vector<MeshDraw> meshes;
+    std::vector<uint64_t> releases;
+
+    // Profiled frame that built the packet, -1 for none. The drawing thread fills in the times
+    // and the main thread collects them once the packet comes back, clear() leaves them alone.
+    long long profileFrame = -1;
+    double drawMs = 0.0;
+    double presentMs = 0.0;
+
+    // Keeps the capacity of the per frame arrays
+    void clear();
+    MeshUpload& addUpload(uint64_t mesh);
+    void addInstance(const glm::vec3& position, const glm::vec3& size, LODLevel lod);
+};
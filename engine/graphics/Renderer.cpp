@@ -2,20 +2,76 @@
 
 #include "Renderer.h"
 
-Renderer::Renderer(GLFWwindow* window) : m_window(window) {
+Renderer::Renderer() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
+
+    m_batchRenderer = new BatchRenderer();
+    m_meshes = new MeshCache();
+}
+
+Renderer::~Renderer() {
+    delete m_meshes;
+    delete m_batchRenderer;
+}
+
+void Renderer::setupState(int width, int height) {
+    glViewport(0, 0, width, height);
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    GLfloat lightPos[] = {5.0f, 5.0f, 5.0f, 1.0f};
+    GLfloat lightAmbient[] = {0.3f, 0.3f, 0.3f, 1.0f};
+    GLfloat lightDiffuse[] = {0.8f, 0.8f, 0.8f, 1.0f};
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
+
+    GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    GLfloat matShininess[] = {50.0f};
+    glMaterialfv(GL_FRONT, GL_SPECULAR, matSpecular);
+    glMaterialfv(GL_FRONT, GL_SHININESS, matShininess);
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    glEnable(GL_COLOR_MATERIAL);
+}
+
+void Renderer::submit(const RenderPacket& packet, FrameArena& arena) {
+    for (const MeshUpload& upload : packet.uploads) {
+        m_meshes->upload(upload);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(&packet.projection[0][0]);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(&packet.view[0][0]);
+
+    for (const BoxDraw& box : packet.boxes) {
+        drawBox(box.position, box.size);
+    }
+    for (const MeshDraw& draw : packet.meshes) {
+        m_meshes->draw(draw);
+    }
+    m_meshes->end();
+    m_batchRenderer->draw(packet.instances, packet.view, arena);
+
+    m_meshes->free(packet.releases);
 }
 
 void Renderer::drawBox(Box* box) {
-    float x = box->position.x;
-    float y = box->position.y;
-    float z = box->position.z;
+    drawBox(box->position, box->size);
+}
+
+void Renderer::drawBox(const glm::vec3& position, const glm::vec3& size) {
+    float x = position.x;
+    float y = position.y;
+    float z = position.z;
 
-    float hx = box->size.x / 2.0f;
-    float hy = box->size.y / 2.0f;
-    float hz = box->size.z / 2.0f;
+    float hx = size.x / 2.0f;
+    float hy = size.y / 2.0f;
+    float hz = size.z / 2.0f;
 
     glBegin(GL_QUADS);
     // Front face
@@ -1,14 +1,32 @@
 #pragma once
 #include <GL/glew.h>
 #include "../scene/Box.h"
-#include <GLFW/glfw3.h>
+#include "RenderPacket.h"
+#include "BatchRenderer.h"
+#include "MeshCache.h"
 
+// Everything here needs the GL context current on the calling thread
 class Renderer {
 public:
-    Renderer(GLFWwindow* window);
+    Renderer();
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    // Viewport, lights and materials, once on the thread that will draw
+    void setupState(int width, int height);
+    // Clears the frame and draws the packet, uploading and freeing its meshes. Scratch memory
+    // comes from the arena of the drawing thread.
+    void submit(const RenderPacket& packet, FrameArena& arena);
+
     void drawBox(Box* box);
-    GLFWwindow* getWindow() { return m_window; }
+    void drawBox(const glm::vec3& position, const glm::vec3& size);
+    MeshCache* getMeshCache() { return m_meshes; }
+    // Its path may only change while nothing draws, before run() or on the drawing thread
+    BatchRenderer* getBatchRenderer() { return m_batchRenderer; }
 
 private:
-    GLFWwindow* m_window;
+    BatchRenderer* m_batchRenderer;
+    MeshCache* m_meshes;
 };
@@ -0,0 +1,175 @@
+#include "StaticGeometry.h"
+#include "MeshCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Corners of a unit box per face, same winding as BatchRenderer::drawBoxGeometry
+const float kFaceNormals[6][3] = {
+    {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}, {-1.0f, 0.0f, 0.0f},
+    {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}
+};
+
+const float kFaceCorners[6][4][3] = {
+    {{-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}},
+    {{-1, -1, -1}, {-1, 1, -1}, {1, 1, -1}, {1, -1, -1}},
+    {{-1, -1, -1}, {-1, -1, 1}, {-1, 1, 1}, {-1, 1, -1}},
+    {{1, -1, -1}, {1, 1, -1}, {1, 1, 1}, {1, -1, 1}},
+    {{-1, 1, -1}, {-1, 1, 1}, {1, 1, 1}, {1, 1, -1}},
+    {{-1, -1, -1}, {1, -1, -1}, {1, -1, 1}, {-1, -1, 1}}
+};
+
+const int kFloatsPerVertex = 6;
+
+}
+
+StaticGeometry::StaticGeometry(float chunkSize)
+    : m_chunkSize(chunkSize > 0.0f ? chunkSize : 32.0f), m_entityCount(0) {
+}
+
+StaticGeometry::~StaticGeometry() {
+    clear();
+}
+
+uint64_t StaticGeometry::chunkKey(const glm::vec3& position) const {
+    // 21 bits per axis, worlds bigger than a million chunks wrap around
+    auto axis = [this](float v) {
+        float cell = std::floor(v / m_chunkSize);
+        int64_t c = std::isfinite(cell) ? (int64_t)std::max(-1048576.0f, std::min(1048575.0f, cell)) : 0;
+        return (uint64_t)(c & 0x1FFFFF);
+    };
+    return axis(position.x) | (axis(position.y) << 21) | (axis(position.z) << 42);
+}
+
+StaticGeometry::Chunk* StaticGeometry::findChunk(const glm::vec3& position) const {
+    auto it = m_chunkLookup.find(chunkKey(position));
+    return it != m_chunkLookup.end() ? m_chunks[it->second] : nullptr;
+}
+
+void StaticGeometry::add(EntityHandle entity, const glm::vec3& position) {
+    uint64_t key = chunkKey(position);
+    auto it = m_chunkLookup.find(key);
+
+    Chunk* chunk;
+    if (it == m_chunkLookup.end()) {
+        chunk = new Chunk();
+        m_chunkLookup[key] = m_chunks.size();
+        m_chunks.push_back(chunk);
+    } else {
+        chunk = m_chunks[it->second];
+    }
+
+    chunk->entities.push_back(entity);
+    chunk->dirty = true;
+    m_entityCount++;
+}
+
+void StaticGeometry::remove(EntityHandle entity, const glm::vec3& position) {
+    Chunk* chunk = findChunk(position);
+    if (!chunk) {
+        return;
+    }
+
+    // From the back, whole groups of entities tend to go in the reverse order they came in
+    auto it = std::find(chunk->entities.rbegin(), chunk->entities.rend(), entity);
+    if (it != chunk->entities.rend()) {
+        *it = chunk->entities.back();
+        chunk->entities.pop_back();
+        chunk->dirty = true;
+        m_entityCount--;
+    }
+}
+
+void StaticGeometry::move(EntityHandle entity, const glm::vec3& oldPosition, const glm::vec3& newPosition) {
+    if (chunkKey(oldPosition) == chunkKey(newPosition)) {
+        touch(newPosition);
+        return;
+    }
+    remove(entity, oldPosition);
+    add(entity, newPosition);
+}
+
+void StaticGeometry::touch(const glm::vec3& position) {
+    Chunk* chunk = findChunk(position);
+    if (chunk) {
+        chunk->dirty = true;
+    }
+}
+
+void StaticGeometry::clear() {
+    for (Chunk* chunk : m_chunks) {
+        MeshCache::release(chunk->mesh);
+        delete chunk;
+    }
+    m_chunks.clear();
+    m_chunkLookup.clear();
+    m_entityCount = 0;
+}
+
+void StaticGeometry::bake(Chunk* chunk, const EntityStorage& entities, RenderPacket& packet) {
+    const std::vector<glm::vec3>& positions = entities.getPositions();
+    const std::vector<glm::vec3>& sizes = entities.getSizes();
+
+    if (!chunk->mesh) {
+        chunk->mesh = MeshCache::createId();
+    }
+    std::vector<float>& vertices = packet.addUpload(chunk->mesh).vertices;
+    vertices.reserve(chunk->entities.size() * 24 * kFloatsPerVertex);
+
+    bool first = true;
+    for (EntityHandle entity : chunk->entities) {
+        int index = entities.indexOf(entity);
+        if (index < 0) {
+            continue;
+        }
+
+        glm::vec3 center = positions[index];
+        glm::vec3 half = sizes[index] * 0.5f;
+        AABB bounds(center - half, center + half);
+        chunk->bounds.min = first ? bounds.min : glm::min(chunk->bounds.min, bounds.min);
+        chunk->bounds.max = first ? bounds.max : glm::max(chunk->bounds.max, bounds.max);
+        first = false;
+
+        for (int face = 0; face < 6; face++) {
+            for (int corner = 0; corner < 4; corner++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    vertices.push_back(center[axis] + half[axis] * kFaceCorners[face][corner][axis]);
+                }
+                for (int axis = 0; axis < 3; axis++) {
+                    vertices.push_back(kFaceNormals[face][axis]);
+                }
+            }
+        }
+    }
+
+    chunk->vertexCount = (int)(vertices.size() / kFloatsPerVertex);
+    chunk->dirty = false;
+}
+
+int StaticGeometry::draw(const EntityStorage& entities, const Frustum* frustum, const LODSystem* lod, const glm::vec3& cameraPos,
+                         RenderPacket& packet) {
+    int drawn = 0;
+
+    for (Chunk* chunk : m_chunks) {
+        if (chunk->dirty) {
+            bake(chunk, entities, packet);
+        }
+        if (chunk->vertexCount == 0) {
+            continue;
+        }
+
+        if (frustum && !frustum->isAABBVisible(chunk->bounds)) {
+            continue;
+        }
+        // The closest point of the chunk decides, so a chunk is only dropped when all of it is out of range
+        if (lod && lod->calculateLOD(glm::clamp(cameraPos, chunk->bounds.min, chunk->bounds.max), cameraPos) == LODLevel::CULLED) {
+            continue;
+        }
+
+        packet.meshes.push_back({chunk->mesh, 0, GL_QUADS, chunk->vertexCount});
+        drawn += (int)chunk->entities.size();
+    }
+
+    return drawn;
+}
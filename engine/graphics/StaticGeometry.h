@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../scene/EntityStorage.h"
+#include "../scene/AABB.h"
+#include "Frustum.h"
+#include "../systems/LODSystem.h"
+#include "RenderPacket.h"
+
+// Static entities baked into chunks on a regular grid. Every chunk is one mesh with all its boxes
+// and is culled and drawn as a whole. Meshes are rebaked lazily on the first draw after the chunk
+// changed and sent with the render packet, nothing here needs the GL context.
+class StaticGeometry {
+public:
+    explicit StaticGeometry(float chunkSize = 32.0f);
+    ~StaticGeometry();
+
+    void add(EntityHandle entity, const glm::vec3& position);
+    void remove(EntityHandle entity, const glm::vec3& position);
+    void move(EntityHandle entity, const glm::vec3& oldPosition, const glm::vec3& newPosition);
+    // Marks the chunk dirty without moving the entity, for size changes
+    void touch(const glm::vec3& position);
+    void clear();
+
+    // Adds the visible chunks to the packet, frustum and lod may be null. Returns how many
+    // entities were drawn.
+    int draw(const EntityStorage& entities, const Frustum* frustum, const LODSystem* lod, const glm::vec3& cameraPos,
+             RenderPacket& packet);
+
+    float getChunkSize() const { return m_chunkSize; }
+    size_t getChunkCount() const { return m_chunks.size(); }
+    size_t getEntityCount() const { return m_entityCount; }
+
+private:
+    struct Chunk {
+        std::vector<EntityHandle> entities;
+        AABB bounds;
+        uint64_t mesh = 0; // MeshCache id
+        int vertexCount = 0;
+        bool dirty = true;
+    };
+
+    float m_chunkSize;
+    std::vector<Chunk*> m_chunks;
+    std::unordered_map<uint64_t, size_t> m_chunkLookup; // packed chunk coordinate -> m_chunks
+    size_t m_entityCount;
+
+    uint64_t chunkKey(const glm::vec3& position) const;
+    Chunk* findChunk(const glm::vec3& position) const;
+    void bake(Chunk* chunk, const EntityStorage& entities, RenderPacket& packet);
+};
@@ -0,0 +1,66 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "WindowBackend.h"
+#include "Renderer.h"
+#include <iostream>
+
+WindowBackend::WindowBackend() : m_glfwReady(false), m_vsync(true), m_window(nullptr), m_renderer(nullptr) {}
+
+WindowBackend::~WindowBackend() {
+    delete m_renderer;
+    if (m_glfwReady) {
+        glfwTerminate();
+    }
+}
+
+bool WindowBackend::initialize(int width, int height, const char* title) {
+    if (!glfwInit()) {
+        std::cerr << "Failed to init GLFW\n";
+        return false;
+    }
+    m_glfwReady = true;
+
+    m_window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    if (!m_window) {
+        std::cerr << "Failed to create GLFW window\n";
+        return false;
+    }
+    glfwMakeContextCurrent(m_window);
+
+    m_renderer = createRenderer();
+    return m_renderer != nullptr;
+}
+
+void WindowBackend::makeCurrent(bool current) {
+    glfwMakeContextCurrent(current ? m_window : nullptr);
+}
+
+void WindowBackend::setupState(int width, int height) {
+    // The swap interval belongs to the context, so it's set on the thread that draws
+    glfwSwapInterval(m_vsync ? 1 : 0);
+    m_renderer->setupState(width, height);
+}
+
+void WindowBackend::submit(const RenderPacket& packet, FrameArena& arena) {
+    m_renderer->submit(packet, arena);
+}
+
+void WindowBackend::present() {
+    glfwSwapBuffers(m_window);
+}
+
+bool WindowBackend::shouldClose() {
+    return glfwWindowShouldClose(m_window);
+}
+
+void WindowBackend::pollEvents() {
+    glfwPollEvents();
+}
+
+double WindowBackend::getTime() {
+    return glfwGetTime();
+}
+
+void WindowBackend::getFramebufferSize(int& width, int& height) {
+    glfwGetFramebufferSize(m_window, &width, &height);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "RenderBackend.h"
+
+// A GLFW window, vsync on unless turned off
+class WindowBackend : public RenderBackend {
+public:
+    WindowBackend();
+    ~WindowBackend() override;
+
+    bool initialize(int width, int height, const char* title) override;
+
+    void makeCurrent(bool current) override;
+    void setupState(int width, int height) override;
+    void submit(const RenderPacket& packet, FrameArena& arena) override;
+    void present() override;
+
+    bool shouldClose() override;
+    void pollEvents() override;
+    double getTime() override;
+    void getFramebufferSize(int& width, int& height) override;
+    void setVsync(bool enable) override { m_vsync = enable; }
+
+    GLFWwindow* getWindow() override { return m_window; }
+    Renderer* getRenderer() override { return m_renderer; }
+
+private:
+    bool m_glfwReady;
+    bool m_vsync;
+    GLFWwindow* m_window;
+    Renderer* m_renderer;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box, the common bounds type of the spatial indices
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    AABB() : min(0.0f), max(0.0f) {}
+    AABB(const glm::vec3& minCorner, const glm::vec3& maxCorner) : min(minCorner), max(maxCorner) {}
+
+    static AABB fromCenterSize(const glm::vec3& center, const glm::vec3& size) {
+        glm::vec3 halfSize = size * 0.5f;
+        return AABB(center - halfSize, center + halfSize);
+    }
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 size() const { return max - min; }
+
+    bool overlaps(const AABB& other) const {
+        return !(max.x < other.min.x || min.x > other.max.x ||
+                 max.y < other.min.y || min.y > other.max.y ||
+                 max.z < other.min.z || min.z > other.max.z);
+    }
+
+    bool contains(const AABB& other) const {
+        return (other.min.x >= min.x && other.max.x <= max.x &&
+                other.min.y >= min.y && other.max.y <= max.y &&
+                other.min.z >= min.z && other.max.z <= max.z);
+    }
+};
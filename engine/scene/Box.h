@@ -1,8 +1,16 @@
 #pragma once
 #include <glm/glm.hpp>
+#include "AABB.h"
 
 struct Box {
     glm::vec3 position;
     glm::vec3 size;
     Box(glm::vec3 pos, glm::vec3 s) : position(pos), size(s) {}
 };
+
+// Bounds functor for indexing boxes in the spatial indices
+struct BoxBounds {
+    AABB operator()(const Box* box) const {
+        return AABB::fromCenterSize(box->position, box->size);
+    }
+};
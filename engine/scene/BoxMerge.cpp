@@ -0,0 +1,132 @@
+#include "BoxMerge.h"
+#include "AABB.h"
+#include <algorithm>
+#include <unordered_set>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+const size_t kTrianglesPerBox = 12;
+
+size_t countChunks(const std::vector<glm::vec3>& positions, float chunkSize) {
+    std::unordered_set<uint64_t> chunks;
+    for (const glm::vec3& p : positions) {
+        uint64_t key = 0;
+        for (int i = 0; i < 3; i++) {
+            float cell = std::floor(p[i] / chunkSize);
+            int64_t c = std::isfinite(cell) ? (int64_t)std::max(-1048576.0f, std::min(1048575.0f, cell)) : 0;
+            key |= (uint64_t)(c & 0x1FFFFF) << (21 * i);
+        }
+        chunks.insert(key);
+    }
+    return chunks.size();
+}
+
+bool isFinite(const AABB& box) {
+    for (int i = 0; i < 3; i++) {
+        if (!std::isfinite(box.min[i]) || !std::isfinite(box.max[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One sweep along axis, returns true when anything merged
+bool mergeAlong(std::vector<AABB>& boxes, int axis, float tolerance) {
+    int a1 = (axis + 1) % 3;
+    int a2 = (axis + 2) % 3;
+    float step = tolerance > 0.0f ? tolerance : 1e-5f;
+
+    // Boxes that can merge along axis share their quantized cross section
+    struct Entry {
+        int64_t key[4];
+        float start;
+        size_t index;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<AABB> result;
+    entries.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        const AABB& b = boxes[i];
+        if (!isFinite(b)) {
+            result.push_back(b);
+            continue;
+        }
+        entries.push_back({{std::llround(b.min[a1] / step), std::llround(b.max[a1] / step),
+                            std::llround(b.min[a2] / step), std::llround(b.max[a2] / step)},
+                           b.min[axis], i});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& l, const Entry& r) {
+        for (int k = 0; k < 4; k++) {
+            if (l.key[k] != r.key[k]) return l.key[k] < r.key[k];
+        }
+        return l.start < r.start;
+    });
+
+    bool merged = false;
+    for (size_t i = 0; i < entries.size();) {
+        AABB current = boxes[entries[i].index];
+        size_t j = i + 1;
+        for (; j < entries.size() && std::equal(entries[j].key, entries[j].key + 4, entries[i].key); j++) {
+            const AABB& next = boxes[entries[j].index];
+            if (next.min[axis] <= current.max[axis] + tolerance) {
+                current.min = glm::min(current.min, next.min);
+                current.max = glm::max(current.max, next.max);
+                merged = true;
+            } else {
+                result.push_back(current);
+                current = next;
+            }
+        }
+        result.push_back(current);
+        i = j;
+    }
+
+    boxes.swap(result);
+    return merged;
+}
+
+}
+
+BoxMergeStats mergeBoxes(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& sizes,
+                         float tolerance, float chunkSize) {
+    BoxMergeStats stats;
+    size_t count = std::min(positions.size(), sizes.size());
+    stats.boxesBefore = count;
+    stats.trianglesBefore = count * kTrianglesPerBox;
+    stats.drawsBefore = countChunks(positions, chunkSize);
+
+    std::vector<AABB> boxes;
+    boxes.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        boxes.push_back(AABB::fromCenterSize(positions[i], sizes[i]));
+    }
+
+    // Strips first, then slabs out of equal strips, then blocks out of equal slabs. A second round
+    // only helps when a later sweep produced new equal cross sections for an earlier axis.
+    const int axes[3] = {0, 2, 1};
+    for (int round = 0; round < 4; round++) {
+        bool merged = false;
+        for (int axis : axes) {
+            merged |= mergeAlong(boxes, axis, tolerance);
+        }
+        if (!merged) {
+            break;
+        }
+    }
+
+    positions.resize(boxes.size());
+    sizes.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        positions[i] = boxes[i].center();
+        sizes[i] = boxes[i].size();
+    }
+
+    stats.boxesAfter = boxes.size();
+    stats.trianglesAfter = boxes.size() * kTrianglesPerBox;
+    stats.drawsAfter = countChunks(positions, chunkSize);
+    return stats;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct BoxMergeStats {
+    size_t boxesBefore = 0;
+    size_t boxesAfter = 0;
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter = 0;
+    // Static chunks the boxes fall into, one draw call each
+    size_t drawsBefore = 0;
+    size_t drawsAfter = 0;
+};
+
+// Greedily fuses boxes that touch along one axis and have the same cross section, first into
+// strips along x, then into slabs along z, then into blocks along y. Gaps and differences up to
+// tolerance still count as touching. Boxes are given as centers and sizes like createRects takes
+// them, and are replaced with the merged set. Only meant for static boxes, the merged boxes no
+// longer map to the original entities.
+BoxMergeStats mergeBoxes(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& sizes,
+                         float tolerance = 0.001f, float chunkSize = 32.0f);
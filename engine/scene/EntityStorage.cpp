@@ -0,0 +1,260 @@
+#include "EntityStorage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Spreads the low 21 bits of v so there are two zero bits between each
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFFull;
+    v = (v | v << 16) & 0x1F0000FF0000FFull;
+    v = (v | v << 8) & 0x100F00F00F00F00Full;
+    v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+}
+
+EntityHandle EntityStorage::create(const glm::vec3& position, const glm::vec3& size, bool isStatic) {
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = (uint32_t)m_slots.size();
+        m_slots.push_back({kNoRow, 1, kNoChange});
+    }
+
+    m_slots[slot].row = (uint32_t)m_positions.size();
+    m_positions.push_back(position);
+    m_sizes.push_back(size);
+    m_static.push_back(isStatic ? 1 : 0);
+    m_rowSlots.push_back(slot);
+
+    return EntityHandle(slot, m_slots[slot].generation);
+}
+
+bool EntityStorage::destroy(EntityHandle handle) {
+    int index = indexOf(handle);
+    if (index < 0) {
+        return false;
+    }
+
+    // Swap and pop, the last row moves into the hole and its slot is pointed at the new row
+    uint32_t row = (uint32_t)index;
+    uint32_t last = (uint32_t)m_positions.size() - 1;
+    if (row != last) {
+        m_positions[row] = m_positions[last];
+        m_sizes[row] = m_sizes[last];
+        m_static[row] = m_static[last];
+        m_rowSlots[row] = m_rowSlots[last];
+        m_slots[m_rowSlots[row]].row = row;
+    }
+    m_positions.pop_back();
+    m_sizes.pop_back();
+    m_static.pop_back();
+    m_rowSlots.pop_back();
+
+    Slot& slot = m_slots[handle.index];
+    if (slot.change != kNoChange) {
+        m_changes[slot.change].entity = EntityHandle();
+        slot.change = kNoChange;
+    }
+    slot.row = kNoRow;
+    slot.generation = EntityHandle::nextGeneration(slot.generation);
+    m_freeSlots.push_back(handle.index);
+    return true;
+}
+
+void EntityStorage::clear() {
+    // Bump every live slot so outstanding handles go stale
+    for (uint32_t slot : m_rowSlots) {
+        m_slots[slot].row = kNoRow;
+        m_slots[slot].change = kNoChange;
+        m_slots[slot].generation = EntityHandle::nextGeneration(m_slots[slot].generation);
+        m_freeSlots.push_back(slot);
+    }
+
+    m_positions.clear();
+    m_sizes.clear();
+    m_static.clear();
+    m_rowSlots.clear();
+    m_changes.clear();
+}
+
+bool EntityStorage::setPosition(EntityHandle handle, const glm::vec3& position) {
+    int index = indexOf(handle);
+    if (index < 0) {
+        return false;
+    }
+
+    recordChange(handle.index);
+    m_positions[index] = position;
+    return true;
+}
+
+bool EntityStorage::setSize(EntityHandle handle, const glm::vec3& size) {
+    int index = indexOf(handle);
+    if (index < 0) {
+        return false;
+    }
+
+    recordChange(handle.index);
+    m_sizes[index] = size;
+    return true;
+}
+
+void EntityStorage::recordChange(uint32_t slot) {
+    // Only the first change keeps the old bounds, later ones just update the columns
+    Slot& s = m_slots[slot];
+    if (s.change != kNoChange) {
+        return;
+    }
+
+    s.change = (uint32_t)m_changes.size();
+    m_changes.push_back({EntityHandle(slot, s.generation), boundsAt(s.row)});
+}
+
+void EntityStorage::clearChanges() {
+    for (const EntityChange& change : m_changes) {
+        if (!change.entity.isNull()) {
+            m_slots[change.entity.index].change = kNoChange;
+        }
+    }
+    m_changes.clear();
+}
+
+AABB EntityStorage::unchangedBounds(size_t index) const {
+    uint32_t change = m_slots[m_rowSlots[index]].change;
+    return change != kNoChange ? m_changes[change].oldBounds : boundsAt(index);
+}
+
+void EntityStorage::reserve(size_t count) {
+    m_positions.reserve(count);
+    m_sizes.reserve(count);
+    m_static.reserve(count);
+    m_rowSlots.reserve(count);
+    m_slots.reserve(count);
+}
+
+void EntityStorage::sortSpatially() {
+    size_t count = m_positions.size();
+    if (count < 2) {
+        return;
+    }
+
+    glm::vec3 min(0.0f), max(0.0f);
+    bool first = true;
+    for (const glm::vec3& p : m_positions) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+            continue;
+        }
+        min = first ? p : glm::min(min, p);
+        max = first ? p : glm::max(max, p);
+        first = false;
+    }
+
+    // 21 bits per axis over the bounds of all entities, non finite positions go last
+    const float cells = 2097151.0f;
+    glm::vec3 extent = glm::max(max - min, glm::vec3(1e-6f));
+    glm::vec3 scale = glm::vec3(cells) / extent;
+
+    struct Key {
+        uint64_t code;
+        uint32_t row;
+    };
+    std::vector<Key> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3& p = m_positions[i];
+        uint64_t code = ~0ull;
+        if (std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z)) {
+            glm::vec3 cell = glm::clamp((p - min) * scale, glm::vec3(0.0f), glm::vec3(cells));
+            code = spreadBits((uint64_t)cell.x) | spreadBits((uint64_t)cell.y) << 1 | spreadBits((uint64_t)cell.z) << 2;
+        }
+        keys[i] = {code, (uint32_t)i};
+    }
+    std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+        return a.code != b.code ? a.code < b.code : a.row < b.row;
+    });
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::vec3> sizes(count);
+    std::vector<uint8_t> statics(count);
+    std::vector<uint32_t> rowSlots(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t row = keys[i].row;
+        positions[i] = m_positions[row];
+        sizes[i] = m_sizes[row];
+        statics[i] = m_static[row];
+        rowSlots[i] = m_rowSlots[row];
+        m_slots[rowSlots[i]].row = (uint32_t)i;
+    }
+
+    m_positions.swap(positions);
+    m_sizes.swap(sizes);
+    m_static.swap(statics);
+    m_rowSlots.swap(rowSlots);
+}
+
+bool EntityStorage::isAlive(EntityHandle handle) const {
+    return indexOf(handle) >= 0;
+}
+
+int EntityStorage::indexOf(EntityHandle handle) const {
+    if (handle.index >= m_slots.size()) {
+        return -1;
+    }
+
+    const Slot& slot = m_slots[handle.index];
+    if (slot.generation != handle.generation || slot.row == kNoRow) {
+        return -1;
+    }
+    return (int)slot.row;
+}
+
+bool EntityStorage::load(const glm::vec3* positions, const glm::vec3* sizes, const uint8_t* statics,
+                         const uint32_t* rowSlots, size_t count, const uint32_t* generations, size_t slotCount) {
+    // clear() still walks the old slots, they go after it
+    clear();
+    m_slots.clear();
+    m_freeSlots.clear();
+    if (count > slotCount || slotCount >= kNoRow) {
+        return false;
+    }
+
+    m_slots.resize(slotCount);
+    for (size_t i = 0; i < slotCount; i++) {
+        if (generations[i] == 0) {
+            m_slots.clear();
+            m_freeSlots.clear();
+            return false;
+        }
+        m_slots[i] = {kNoRow, generations[i], kNoChange};
+    }
+
+    // Every row needs its own slot
+    for (size_t row = 0; row < count; row++) {
+        uint32_t slot = rowSlots[row];
+        if (slot >= slotCount || m_slots[slot].row != kNoRow) {
+            m_slots.clear();
+            m_freeSlots.clear();
+            return false;
+        }
+        m_slots[slot].row = (uint32_t)row;
+    }
+
+    // Lowest slots are reused first
+    for (size_t i = slotCount; i > 0; i--) {
+        if (m_slots[i - 1].row == kNoRow) {
+            m_freeSlots.push_back((uint32_t)(i - 1));
+        }
+    }
+
+    m_positions.assign(positions, positions + count);
+    m_sizes.assign(sizes, sizes + count);
+    m_static.assign(statics, statics + count);
+    m_rowSlots.assign(rowSlots, rowSlots + count);
+    return true;
+}
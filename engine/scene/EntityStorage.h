@@ -0,0 +1,112 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "AABB.h"
+
+// Refers to an entity in an EntityStorage. The generation changes whenever a slot is reused,
+// so handles to destroyed entities are detected instead of aliasing a newer entity.
+struct EntityHandle {
+    uint32_t index;
+    uint32_t generation; // 0 is never handed out
+
+    EntityHandle() : index(0), generation(0) {}
+    EntityHandle(uint32_t i, uint32_t g) : index(i), generation(g) {}
+
+    bool isNull() const { return generation == 0; }
+    // Wraps past 0 so a recycled slot never produces a null handle
+    static uint32_t nextGeneration(uint32_t generation) { return generation == 0xFFFFFFFFu ? 1 : generation + 1; }
+    bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+// An entity whose position or size changed, with the bounds it had before the first change
+struct EntityChange {
+    EntityHandle entity; // null once the entity is destroyed
+    AABB oldBounds;
+};
+
+// Entity data as dense structure of arrays columns. Handles map to dense rows through a slot
+// table, removal swaps the last row into the hole so the columns never have gaps. Row order
+// is not stable, keep handles around instead of row indices.
+class EntityStorage {
+public:
+    EntityStorage() = default;
+
+    EntityHandle create(const glm::vec3& position, const glm::vec3& size, bool isStatic = false);
+    bool destroy(EntityHandle handle);
+    void clear();
+    void reserve(size_t count);
+    // Reorders the rows along a Morton curve of the positions, so entities that are close in space
+    // are close in memory. Handles stay valid, row indices do not.
+    void sortSpatially();
+    // Replaces everything with saved columns and slot generations, as written from the getters
+    // below. Returns false and leaves the storage empty when they do not fit together.
+    bool load(const glm::vec3* positions, const glm::vec3* sizes, const uint8_t* statics, const uint32_t* rowSlots,
+              size_t count, const uint32_t* generations, size_t slotCount);
+
+    // Changes are recorded once per entity until clearChanges(), so indices can catch up later
+    bool setPosition(EntityHandle handle, const glm::vec3& position);
+    bool setSize(EntityHandle handle, const glm::vec3& size);
+    const std::vector<EntityChange>& getChanges() const { return m_changes; }
+    void clearChanges();
+    // Bounds as of the last clearChanges(), what the spatial indices still have
+    AABB unchangedBounds(size_t index) const;
+
+    bool isAlive(EntityHandle handle) const;
+    // Dense row of a live entity, -1 for stale or null handles
+    int indexOf(EntityHandle handle) const;
+    EntityHandle handleAt(size_t index) const { return EntityHandle(m_rowSlots[index], m_slots[m_rowSlots[index]].generation); }
+
+    size_t size() const { return m_positions.size(); }
+    size_t capacity() const { return m_positions.capacity(); }
+    bool empty() const { return m_positions.empty(); }
+
+    // Dense columns, row i of every column belongs to the same entity
+    const std::vector<glm::vec3>& getPositions() const { return m_positions; }
+    const std::vector<glm::vec3>& getSizes() const { return m_sizes; }
+
+    const std::vector<uint8_t>& getStaticFlags() const { return m_static; }
+    const std::vector<uint32_t>& getRowSlots() const { return m_rowSlots; }
+    bool isStaticAt(size_t index) const { return m_static[index] != 0; }
+
+    size_t slotCount() const { return m_slots.size(); }
+    uint32_t generationAt(size_t slot) const { return m_slots[slot].generation; }
+
+    AABB boundsAt(size_t index) const { return AABB::fromCenterSize(m_positions[index], m_sizes[index]); }
+
+private:
+    static const uint32_t kNoRow = 0xFFFFFFFFu;
+    static const uint32_t kNoChange = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t row;
+        uint32_t generation;
+        uint32_t change; // index into m_changes
+    };
+
+    void recordChange(uint32_t slot);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_sizes;
+    std::vector<uint8_t> m_static;
+    std::vector<uint32_t> m_rowSlots; // dense row -> slot
+
+    std::vector<EntityChange> m_changes;
+};
+
+// Bounds functor for indexing entity handles in the spatial indices
+struct EntityBounds {
+    const EntityStorage* storage;
+
+    explicit EntityBounds(const EntityStorage* entities = nullptr) : storage(entities) {}
+
+    AABB operator()(EntityHandle handle) const {
+        int index = storage->indexOf(handle);
+        return index >= 0 ? storage->boundsAt(index) : AABB();
+    }
+};
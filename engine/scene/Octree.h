@@ -1,99 +1,1222 @@
 #pragma once
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <iostream>
 #include <glm/glm.hpp>
+#include "AABB.h"
 #include "Box.h"
+#include "SpatialQuery.h"
 #include "../graphics/Frustum.h"
 
-struct OctreeNode {
+enum class OctreeBoundsPrecision {
+    Bits8,
+    Bits16
+};
+
+// Flattened node of the compressed octree. Only non-empty children are kept,
+// stored next to each other at [firstChild, firstChild + childCount). A packed node can be
+// bigger than its tree node, so it also covers objects the root could not grow to reach.
+struct PackedOctreeNode {
     glm::vec3 center;
     float halfSize;
-    std::vector<Box*> objects;
-    OctreeNode* children[8];
-    bool isLeaf;
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t firstObject;
+    uint32_t objectCount;
+};
 
-    OctreeNode(const glm::vec3& c, float hs)
-        : center(c), halfSize(hs), isLeaf(true) {
-        for (int i = 0; i < 8; i++) children[i] = nullptr;
-        objects.reserve(8); // Pre-allocate for better performance
-    }
+// Object bounds relative to the owning node, rounded outward so tests stay conservative
+struct QuantizedBounds8 {
+    typedef uint8_t Type;
+    static const int kSteps = 255;
 
-    ~OctreeNode() {
-        for (int i = 0; i < 8; i++) {
-            delete children[i];
-        }
-    }
+    uint8_t min[3];
+    uint8_t max[3];
+};
 
-    bool contains(const Box* box) const {
-        glm::vec3 halfBoxSize = box->size * 0.5f;
-        glm::vec3 min = center - glm::vec3(halfSize);
-        glm::vec3 max = center + glm::vec3(halfSize);
-        glm::vec3 boxMin = box->position - halfBoxSize;
-        glm::vec3 boxMax = box->position + halfBoxSize;
+struct QuantizedBounds16 {
+    typedef uint16_t Type;
+    static const int kSteps = 65535;
 
-        return (boxMin.x >= min.x && boxMax.x <= max.x &&
-                boxMin.y >= min.y && boxMax.y <= max.y &&
-                boxMin.z >= min.z && boxMax.z <= max.z);
-    }
+    uint16_t min[3];
+    uint16_t max[3];
+};
 
-    bool intersects(const Box* box) const {
-        glm::vec3 halfBoxSize = box->size * 0.5f;
-        glm::vec3 nodeMin = center - glm::vec3(halfSize);
-        glm::vec3 nodeMax = center + glm::vec3(halfSize);
-        glm::vec3 boxMin = box->position - halfBoxSize;
-        glm::vec3 boxMax = box->position + halfBoxSize;
+template <typename Bounds>
+inline void dequantizeBounds(const PackedOctreeNode& node, const Bounds& q, glm::vec3& min, glm::vec3& max) {
+    float step = node.halfSize * 2.0f / (float)Bounds::kSteps;
 
-        return (boxMin.x <= nodeMax.x && boxMax.x >= nodeMin.x &&
-                boxMin.y <= nodeMax.y && boxMax.y >= nodeMin.y &&
-                boxMin.z <= nodeMax.z && boxMax.z >= nodeMin.z);
+    for (int i = 0; i < 3; i++) {
+        float nodeMin = node.center[i] - node.halfSize;
+        min[i] = nodeMin + (float)q.min[i] * step;
+        max[i] = nodeMin + (float)q.max[i] * step;
     }
+}
+
+template <typename Bounds>
+inline Bounds quantizeBounds(const PackedOctreeNode& node, const AABB& bounds) {
+    const int steps = Bounds::kSteps;
+    float step = node.halfSize * 2.0f / (float)steps;
+
+    // Must match the arithmetic in dequantizeBounds exactly
+    auto decode = [step](float nodeMin, int q) { return nodeMin + (float)q * step; };
+    auto clampStep = [steps](float value) {
+        if (!(value > 0.0f)) return 0;
+        if (value >= (float)steps) return steps;
+        return (int)value;
+    };
 
-    bool intersectsFrustum(const Frustum& frustum) const {
-        Box nodeBox(center, glm::vec3(halfSize * 2.0f));
-        return frustum.isBoxVisible(&nodeBox);
+    Bounds q;
+    for (int i = 0; i < 3; i++) {
+        float nodeMin = node.center[i] - node.halfSize;
+
+        // Round outward, then walk past any float error so decoding never shrinks the box
+        int lo = clampStep(std::floor((bounds.min[i] - nodeMin) / step));
+        while (lo > 0 && decode(nodeMin, lo) > bounds.min[i]) lo--;
+        int hi = clampStep(std::ceil((bounds.max[i] - nodeMin) / step));
+        while (hi < steps && decode(nodeMin, hi) < bounds.max[i]) hi++;
+
+        q.min[i] = static_cast<typename Bounds::Type>(lo);
+        q.max[i] = static_cast<typename Bounds::Type>(hi);
     }
+    return q;
+}
+
+struct OctreeMemoryStats {
+    int objectCount = 0;
+    size_t treeBytes = 0;    // nodes with their inline items and overflow lists
+    size_t compactBytes = 0; // packed nodes, payloads and quantized bounds
+
+    float treeBytesPerObject() const { return objectCount ? (float)treeBytes / objectCount : 0.0f; }
+    float compactBytesPerObject() const { return objectCount ? (float)compactBytes / objectCount : 0.0f; }
 };
 
+// Octree over any payload type. BoundsFn maps a payload to its AABB, and payloads are copied
+// into the tree by value together with those bounds, so T is usually a pointer, handle or
+// small struct. remove() compares payloads with operator==.
+//
+// The root grows (re-parents itself) whenever an object lands outside of it, so the initial
+// center and half size are only a starting guess. Leaves split once more than LeafCapacity of
+// their objects would fit in a child. MaxDepth counts levels below the initial root size and is
+// only a safety cap for stacks of coincident objects. Every node keeps LeafCapacity items
+// inline, only straddling objects and crowded leaves at MaxDepth spill into a heap allocated
+// overflow list.
+//
+// In compressed mode compact() packs the tree into flat arrays where every object keeps its
+// bounds inline, quantized against its node. Exact range and AABB tests then go through
+// BoundsFn for candidates only. Any insert or remove makes the packed copy stale until the
+// next compact(). The packed arrays can be saved and handed back to loadCompact(), such a tree
+// answers queries straight away and only builds its nodes on the first insert or remove.
+//
+// The forEach* queries walk the tree with a fixed size stack and hand every match straight to
+// a visitor, so they never allocate. A visitor returning false stops the query early.
+template <typename T, typename BoundsFn, int MaxDepth = 20, int LeafCapacity = 8>
 class Octree {
+    static_assert(MaxDepth > 0, "Octree needs a positive MaxDepth");
+    static_assert(LeafCapacity > 0, "Octree needs a positive LeafCapacity");
+
 public:
-    Octree(const glm::vec3& center = glm::vec3(0.0f),
-           float halfSize = 100.0f,
-           int maxDepth = 5,
-           int maxObjectsPerNode = 8);
+    typedef SpatialItem<T> Item;
+
+    // 32 doublings take a 100 unit root past 10^11 units, anything further out is a broken position
+    static const int kMaxRootGrowth = 32;
+    // Hard limit on tree height (subdivision plus root growth), sizes the traversal stack
+    static const int kMaxHeight = MaxDepth + kMaxRootGrowth;
+
+    explicit Octree(const glm::vec3& center = glm::vec3(0.0f),
+                    float halfSize = 100.0f,
+                    const BoundsFn& boundsFn = BoundsFn());
     ~Octree();
 
-    void insert(Box* box);
-    void remove(Box* box);
+    Octree(const Octree&) = delete;
+    Octree& operator=(const Octree&) = delete;
+
+    void insert(const T& value);
+    // Bulk insert, builds the tree top down in one pass instead of descending once per value
+    void insert(const std::vector<T>& values);
+    // Finds the value through its current bounds, falling back to a full search if it moved.
+    // The second overload takes the bounds it was inserted with.
+    bool remove(const T& value);
+    bool remove(const T& value, const AABB& insertedBounds);
     void clear();
-    void rebuild(const std::vector<Box*>& boxes);
+    void rebuild(const std::vector<T>& values);
 
-    void queryFrustum(const Frustum& frustum, std::vector<Box*>& result) const;
-    void queryRange(const glm::vec3& center, float radius, std::vector<Box*>& result) const;
-    void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<Box*>& result) const;
+    template <typename F>
+    void forEachInFrustum(const Frustum& frustum, F&& fn) const;
+    template <typename F>
+    void forEachInRange(const glm::vec3& center, float radius, F&& fn) const;
+    template <typename F>
+    void forEachInAABB(const glm::vec3& min, const glm::vec3& max, F&& fn) const;
 
-    // Ray casting
-    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Box** hitBox) const;
+    void queryFrustum(const Frustum& frustum, std::vector<T>& result) const;
+    void queryRange(const glm::vec3& center, float radius, std::vector<T>& result) const;
+    void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<T>& result) const;
+
+    // Ray casting, hit is only written when something was hit
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, T* hit) const;
 
     // Statistics
     int getObjectCount() const { return m_objectCount; }
     int getNodeCount() const;
-    int getMaxDepth() const { return m_maxDepth; }
+    int getMaxDepth() const { return MaxDepth; }
+    int getLeafCapacity() const { return LeafCapacity; }
+    int getDepth() const;
+    glm::vec3 getRootCenter() const { return m_treePending ? m_packedNodes[0].center : m_root->center; }
+    float getRootHalfSize() const { return m_treePending ? m_packedNodes[0].halfSize : m_root->halfSize; }
+
+    OctreeMemoryStats getMemoryStats() const;
 
-    // Configuration
-    void setMaxDepth(int depth) { m_maxDepth = depth; }
-    void setMaxObjectsPerNode(int count) { m_maxObjectsPerNode = count; }
+    // Compressed mode
+    void setCompressed(bool enable, OctreeBoundsPrecision precision = OctreeBoundsPrecision::Bits16);
+    bool isCompressed() const { return m_compressed; }
+    bool isCompactValid() const { return m_compressed && m_compactValid; }
+    OctreeBoundsPrecision getBoundsPrecision() const { return m_precision; }
+    void compact();
+
+    // Packed form, valid while isCompactValid()
+    const std::vector<PackedOctreeNode>& getPackedNodes() const { return m_packedNodes; }
+    const std::vector<T>& getPackedObjects() const { return m_packedObjects; }
+    const std::vector<QuantizedBounds8>& getPackedBounds8() const { return m_packedBounds8; }
+    const std::vector<QuantizedBounds16>& getPackedBounds16() const { return m_packedBounds16; }
+    // Replaces the tree with a saved packed form and switches to compressed mode. Returns false
+    // and leaves the tree as it was when the arrays do not describe a valid tree.
+    bool loadCompact(const PackedOctreeNode* nodes, size_t nodeCount, const T* objects, size_t objectCount,
+                     const QuantizedBounds8* bounds);
+    bool loadCompact(const PackedOctreeNode* nodes, size_t nodeCount, const T* objects, size_t objectCount,
+                     const QuantizedBounds16* bounds);
 
 private:
-    OctreeNode* m_root;
-    int m_maxDepth;
-    int m_maxObjectsPerNode;
+    struct Node {
+        glm::vec3 center;
+        float halfSize;
+        Node* children; // block of 8, nullptr for leaves
+        int fitCount;   // objects that would fit in a child, drives subdivision of leaves
+        int count;      // used slots in items, overflow is only used once they are full
+        Item items[LeafCapacity];
+        std::vector<Item> overflow;
+
+        Node() : center(0.0f), halfSize(0.0f), children(nullptr), fitCount(0), count(0) {}
+        ~Node() { delete[] children; }
+
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
+
+        bool isLeaf() const { return children == nullptr; }
+        int objectCount() const { return count + (int)overflow.size(); }
+
+        Item& itemAt(int i) { return i < LeafCapacity ? items[i] : overflow[i - LeafCapacity]; }
+
+        void add(const Item& item) {
+            if (count < LeafCapacity) {
+                items[count++] = item;
+            } else {
+                overflow.push_back(item);
+            }
+        }
+
+        // Swaps the last item into the hole, item order is not kept
+        void removeAt(int i) {
+            int last = objectCount() - 1;
+            if (i != last) {
+                itemAt(i) = std::move(itemAt(last));
+            }
+            if (!overflow.empty()) {
+                overflow.pop_back();
+            } else {
+                count--;
+            }
+        }
+
+        // Moves a whole subtree into this (empty) node
+        void takeFrom(Node& other) {
+            center = other.center;
+            halfSize = other.halfSize;
+            fitCount = other.fitCount;
+            count = other.count;
+            for (int i = 0; i < other.count; i++) {
+                items[i] = std::move(other.items[i]);
+            }
+            overflow.swap(other.overflow);
+            delete[] children;
+            children = other.children;
+            other.children = nullptr;
+            other.count = 0;
+        }
+
+        AABB bounds() const {
+            return AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize));
+        }
+
+        bool contains(const AABB& box) const { return bounds().contains(box); }
+        bool intersects(const AABB& box) const { return bounds().overlaps(box); }
+
+        // True when the box sits fully inside one octant, so a child could hold it
+        bool fitsChild(const AABB& box) const {
+            for (int i = 0; i < 3; i++) {
+                if (box.min[i] < center[i] && box.max[i] > center[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    Node* m_root;
+    BoundsFn m_boundsFn;
+    glm::vec3 m_initialCenter;
+    float m_initialHalfSize;
     int m_objectCount;
+    int m_height; // upper bound on the depth of any node
+    int m_rootLevels; // times the root grew, depth limits count from the initial root size
+
+    bool m_compressed;
+    bool m_compactValid;
+    bool m_treePending; // loaded from the packed form, the node tree is not built yet
+    OctreeBoundsPrecision m_precision;
+    std::vector<PackedOctreeNode> m_packedNodes;
+    std::vector<T> m_packedObjects;
+    std::vector<QuantizedBounds8> m_packedBounds8;
+    std::vector<QuantizedBounds16> m_packedBounds16;
+
+    bool growToContain(const AABB& bounds);
+    void expandRoot(const glm::vec3& towards);
+    void insertRecursive(Node* node, const Item& item, int depth);
+    void buildRecursive(Node* node, Item* items, Item* scratch, uint8_t* buckets, size_t count, int depth);
+    void collectItems(const Node* node, std::vector<Item>& items) const;
+    int childFor(const Node* node, const AABB& bounds) const;
+    static int octantFor(const glm::vec3& center, float halfSize, const AABB& bounds);
+    void createChildren(Node* node, int depth);
+    bool removeRecursive(Node* node, const T& value, const AABB* bounds);
+    void subdivide(Node* node, int depth);
+    int getNodeCountRecursive(const Node* node) const;
+    int getDepthRecursive(const Node* node) const;
+    size_t getTreeBytesRecursive(const Node* node) const;
+
+    void invalidateCompact() { m_compactValid = false; }
+    void ensureTree();
+    template <typename Bounds>
+    bool loadPacked(const PackedOctreeNode* nodes, size_t nodeCount, const T* objects, size_t objectCount,
+                    const Bounds* bounds, std::vector<Bounds>& target, OctreeBoundsPrecision precision);
+    template <typename Bounds>
+    void packObjects(uint32_t nodeIndex, const Node* node, std::vector<Bounds>& bounds);
+
+    // NodeTest(center, halfSize) prunes subtrees, ObjectTest(bounds, value) decides what gets
+    // visited. The packed form hands ObjectTest the dequantized (loosened) bounds.
+    template <typename NodeTest, typename ObjectTest, typename F>
+    bool traverse(NodeTest& nodeTest, ObjectTest& objectTest, F& fn) const;
+    template <typename Bounds, typename NodeTest, typename ObjectTest, typename F>
+    bool traverseCompact(const std::vector<Bounds>& bounds, NodeTest& nodeTest, ObjectTest& objectTest, F& fn) const;
+};
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+Octree<T, BoundsFn, MaxDepth, LeafCapacity>::Octree(const glm::vec3& center, float halfSize, const BoundsFn& boundsFn)
+    : m_boundsFn(boundsFn), m_initialCenter(center), m_initialHalfSize(halfSize),
+      m_objectCount(0), m_height(0), m_rootLevels(0),
+      m_compressed(false), m_compactValid(false), m_treePending(false), m_precision(OctreeBoundsPrecision::Bits16) {
+    m_root = new Node();
+    m_root->center = center;
+    m_root->halfSize = halfSize;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+Octree<T, BoundsFn, MaxDepth, LeafCapacity>::~Octree() {
+    delete m_root;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::insert(const T& value) {
+    ensureTree();
+    Item item = {value, m_boundsFn(value)};
+    if (!growToContain(item.bounds)) {
+        glm::vec3 center = item.bounds.center();
+        std::cerr << "Octree: object at (" << center.x << ", " << center.y << ", " << center.z
+                  << ") is out of range, keeping it at the root\n";
+    }
+
+    insertRecursive(m_root, item, 0);
+    m_objectCount++;
+    invalidateCompact();
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::growToContain(const AABB& bounds) {
+    glm::vec3 p = bounds.center();
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+        return false;
+    }
+
+    for (int i = 0; i < kMaxRootGrowth && m_height + 1 < kMaxHeight && !m_root->contains(bounds); i++) {
+        expandRoot(p);
+    }
+    return m_root->contains(bounds);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::expandRoot(const glm::vec3& towards) {
+    Node* oldRoot = m_root;
+    float halfSize = oldRoot->halfSize;
+
+    // Double the root towards the target, the old root becomes the octant on the opposite side
+    glm::vec3 direction;
+    direction.x = (towards.x >= oldRoot->center.x) ? 1.0f : -1.0f;
+    direction.y = (towards.y >= oldRoot->center.y) ? 1.0f : -1.0f;
+    direction.z = (towards.z >= oldRoot->center.z) ? 1.0f : -1.0f;
+
+    Node* newRoot = new Node();
+    newRoot->center = oldRoot->center + direction * halfSize;
+    newRoot->halfSize = halfSize * 2.0f;
+    newRoot->children = new Node[8];
+
+    int oldIndex = (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 4 : 0);
+    for (int i = 0; i < 8; i++) {
+        Node& child = newRoot->children[i];
+        if (i == oldIndex) {
+            child.takeFrom(*oldRoot);
+            continue;
+        }
+
+        glm::vec3 offset;
+        offset.x = (i & 1) ? halfSize : -halfSize;
+        offset.y = (i & 2) ? halfSize : -halfSize;
+        offset.z = (i & 4) ? halfSize : -halfSize;
+        child.center = newRoot->center + offset;
+        child.halfSize = halfSize;
+    }
+
+    delete oldRoot;
+    m_root = newRoot;
+    m_height++;
+    m_rootLevels++;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::insertRecursive(Node* node, const Item& item, int depth) {
+    if (node->isLeaf()) {
+        node->add(item);
+        if (node->fitsChild(item.bounds)) {
+            node->fitCount++;
+        }
+
+        if (node->fitCount > LeafCapacity && depth < MaxDepth + m_rootLevels && depth + 1 < kMaxHeight) {
+            subdivide(node, depth);
+        }
+        return;
+    }
+
+    int child = childFor(node, item.bounds);
+    if (child >= 0) {
+        insertRecursive(&node->children[child], item, depth + 1);
+    } else {
+        node->add(item);
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::childFor(const Node* node, const AABB& bounds) const {
+    if (!node->fitsChild(bounds)) {
+        return -1;
+    }
+
+    // The octant of the min corner is almost always right, the loop only catches float edge cases
+    int guess = (bounds.min.x >= node->center.x ? 1 : 0) |
+                (bounds.min.y >= node->center.y ? 2 : 0) |
+                (bounds.min.z >= node->center.z ? 4 : 0);
+    if (node->children[guess].contains(bounds)) {
+        return guess;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (node->children[i].contains(bounds)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::octantFor(const glm::vec3& center, float halfSize, const AABB& bounds) {
+    for (int i = 0; i < 3; i++) {
+        if (bounds.min[i] < center[i] && bounds.max[i] > center[i]) {
+            return -1;
+        }
+    }
+
+    // Must place children exactly like createChildren
+    float quarter = halfSize * 0.5f;
+    auto childContains = [&](int i) {
+        glm::vec3 offset;
+        offset.x = (i & 1) ? quarter : -quarter;
+        offset.y = (i & 2) ? quarter : -quarter;
+        offset.z = (i & 4) ? quarter : -quarter;
+        glm::vec3 childCenter = center + offset;
+        return AABB(childCenter - glm::vec3(quarter), childCenter + glm::vec3(quarter)).contains(bounds);
+    };
+
+    int guess = (bounds.min.x >= center.x ? 1 : 0) |
+                (bounds.min.y >= center.y ? 2 : 0) |
+                (bounds.min.z >= center.z ? 4 : 0);
+    if (childContains(guess)) {
+        return guess;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (childContains(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::createChildren(Node* node, int depth) {
+    float quarter = node->halfSize * 0.5f;
+    node->children = new Node[8];
+    m_height = std::max(m_height, depth + 1);
+
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 offset;
+        offset.x = (i & 1) ? quarter : -quarter;
+        offset.y = (i & 2) ? quarter : -quarter;
+        offset.z = (i & 4) ? quarter : -quarter;
+
+        node->children[i].center = node->center + offset;
+        node->children[i].halfSize = quarter;
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::insert(const std::vector<T>& values) {
+    if (values.empty()) {
+        return;
+    }
+    ensureTree();
+
+    // A small batch into a big tree is cheaper as single inserts than as a rebuild
+    if (values.size() < (size_t)m_objectCount) {
+        for (const T& value : values) {
+            insert(value);
+        }
+        return;
+    }
+
+    std::vector<Item> items;
+    items.reserve(m_objectCount + values.size());
+    collectItems(m_root, items);
+    for (const T& value : values) {
+        items.push_back({value, m_boundsFn(value)});
+    }
+
+    // Grow the root once for the whole batch
+    AABB total;
+    bool first = true;
+    for (const Item& item : items) {
+        glm::vec3 p = item.bounds.center();
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+            continue;
+        }
+        total.min = first ? item.bounds.min : glm::min(total.min, item.bounds.min);
+        total.max = first ? item.bounds.max : glm::max(total.max, item.bounds.max);
+        first = false;
+    }
+
+    clear();
+    if (!first && !growToContain(total)) {
+        std::cerr << "Octree: bulk insert spans (" << total.min.x << ", " << total.min.y << ", " << total.min.z
+                  << ") to (" << total.max.x << ", " << total.max.y << ", " << total.max.z
+                  << "), out of range objects are kept at the root\n";
+    }
+
+    std::vector<Item> scratch(items.size());
+    std::vector<uint8_t> buckets(items.size());
+    buildRecursive(m_root, items.data(), scratch.data(), buckets.data(), items.size(), 0);
+    m_objectCount = (int)items.size();
+    invalidateCompact();
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::buildRecursive(Node* node, Item* items, Item* scratch,
+                                                                 uint8_t* buckets, size_t count, int depth) {
+    if (count == 0) {
+        return;
+    }
+
+    // Bucket 0 holds the objects that stay in this node, bucket c + 1 the ones for child c
+    size_t offsets[10] = {0};
+
+    if (node->isLeaf()) {
+        // Children are always placed the same way, so octants can be worked out before they exist
+        int fits = 0;
+        for (size_t i = 0; i < count; i++) {
+            const AABB& bounds = items[i].bounds;
+            if (node->fitsChild(bounds)) {
+                fits++;
+            }
+            buckets[i] = (uint8_t)(octantFor(node->center, node->halfSize, bounds) + 1);
+            offsets[buckets[i] + 1]++;
+        }
+
+        // Same split rule as insertRecursive, so the result matches inserting one by one
+        if (fits <= LeafCapacity || depth >= MaxDepth + m_rootLevels || depth + 1 >= kMaxHeight) {
+            for (size_t i = 0; i < count; i++) {
+                node->add(items[i]);
+            }
+            node->fitCount = fits;
+            return;
+        }
+        createChildren(node, depth);
+    } else {
+        // Only the root after growing, its children may not sit exactly where octantFor expects
+        for (size_t i = 0; i < count; i++) {
+            buckets[i] = (uint8_t)(childFor(node, items[i].bounds) + 1);
+            offsets[buckets[i] + 1]++;
+        }
+    }
+
+    // Counting sort into scratch
+    for (int b = 1; b < 10; b++) {
+        offsets[b] += offsets[b - 1];
+    }
+    for (size_t i = 0; i < count; i++) {
+        scratch[offsets[buckets[i]]++] = items[i];
+    }
+
+    // offsets[b] is now the end of bucket b. The sorted copy becomes the input of the children,
+    // and the old input their scratch space.
+    for (size_t i = 0; i < offsets[0]; i++) {
+        node->add(scratch[i]);
+    }
+    for (int c = 0; c < 8; c++) {
+        size_t begin = offsets[c];
+        buildRecursive(&node->children[c], scratch + begin, items + begin, buckets + begin,
+                       offsets[c + 1] - begin, depth + 1);
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::collectItems(const Node* node, std::vector<Item>& items) const {
+    items.insert(items.end(), node->items, node->items + node->count);
+    items.insert(items.end(), node->overflow.begin(), node->overflow.end());
+    if (!node->isLeaf()) {
+        for (int i = 0; i < 8; i++) {
+            collectItems(&node->children[i], items);
+        }
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::subdivide(Node* node, int depth) {
+    node->fitCount = 0;
+    createChildren(node, depth);
+
+    // Walk backwards so removeAt only ever swaps in items that were already looked at
+    for (int i = node->objectCount() - 1; i >= 0; i--) {
+        const Item& item = node->itemAt(i);
+        int c = childFor(node, item.bounds);
+        if (c >= 0) {
+            Node& child = node->children[c];
+            child.add(item);
+            if (child.fitsChild(item.bounds)) {
+                child.fitCount++;
+            }
+            node->removeAt(i);
+        }
+    }
+
+    // Everything may have landed in one octant, keep splitting while it stays crowded
+    for (int i = 0; i < 8; i++) {
+        Node* child = &node->children[i];
+        if (child->fitCount > LeafCapacity && depth + 1 < MaxDepth + m_rootLevels && depth + 2 < kMaxHeight) {
+            subdivide(child, depth + 1);
+        }
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::removeRecursive(Node* node, const T& value, const AABB* bounds) {
+    int count = node->objectCount();
+    for (int i = 0; i < count; i++) {
+        const Item& item = node->itemAt(i);
+        if (item.value == value) {
+            if (node->isLeaf() && node->fitCount > 0 && node->fitsChild(item.bounds)) {
+                node->fitCount--;
+            }
+            node->removeAt(i);
+            return true;
+        }
+    }
+
+    if (!node->isLeaf()) {
+        for (int i = 0; i < 8; i++) {
+            Node* child = &node->children[i];
+            if ((!bounds || child->intersects(*bounds)) && removeRecursive(child, value, bounds)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::remove(const T& value) {
+    ensureTree();
+    AABB bounds = m_boundsFn(value);
+    if (remove(value, bounds)) {
+        return true;
+    }
+
+    // The payload moved since it was inserted, search the whole tree
+    if (removeRecursive(m_root, value, nullptr)) {
+        m_objectCount--;
+        invalidateCompact();
+        return true;
+    }
+    return false;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::remove(const T& value, const AABB& insertedBounds) {
+    ensureTree();
+    if (removeRecursive(m_root, value, &insertedBounds)) {
+        m_objectCount--;
+        invalidateCompact();
+        return true;
+    }
+    return false;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::clear() {
+    delete m_root;
+    m_root = new Node();
+    m_root->center = m_initialCenter;
+    m_root->halfSize = m_initialHalfSize;
+    m_objectCount = 0;
+    m_height = 0;
+    m_rootLevels = 0;
+    m_treePending = false;
+    invalidateCompact();
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::rebuild(const std::vector<T>& values) {
+    clear();
+    insert(values);
+
+    if (m_compressed) {
+        compact();
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::setCompressed(bool enable, OctreeBoundsPrecision precision) {
+    if (enable == m_compressed && precision == m_precision) {
+        return;
+    }
+    ensureTree();
+    m_compressed = enable;
+    m_precision = precision;
+    invalidateCompact();
+
+    if (!enable) {
+        m_packedNodes = std::vector<PackedOctreeNode>();
+        m_packedObjects = std::vector<T>();
+        m_packedBounds8 = std::vector<QuantizedBounds8>();
+        m_packedBounds16 = std::vector<QuantizedBounds16>();
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::ensureTree() {
+    if (!m_treePending) {
+        return;
+    }
+
+    // The packed objects are everything the tree holds, build the nodes from them
+    m_treePending = false;
+    m_objectCount = 0;
+    std::vector<T> values = m_packedObjects;
+    insert(values);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::loadCompact(const PackedOctreeNode* nodes, size_t nodeCount,
+                                                              const T* objects, size_t objectCount,
+                                                              const QuantizedBounds8* bounds) {
+    return loadPacked(nodes, nodeCount, objects, objectCount, bounds, m_packedBounds8, OctreeBoundsPrecision::Bits8);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::loadCompact(const PackedOctreeNode* nodes, size_t nodeCount,
+                                                              const T* objects, size_t objectCount,
+                                                              const QuantizedBounds16* bounds) {
+    return loadPacked(nodes, nodeCount, objects, objectCount, bounds, m_packedBounds16, OctreeBoundsPrecision::Bits16);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename Bounds>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::loadPacked(const PackedOctreeNode* nodes, size_t nodeCount,
+                                                             const T* objects, size_t objectCount,
+                                                             const Bounds* bounds, std::vector<Bounds>& target,
+                                                             OctreeBoundsPrecision precision) {
+    if (nodeCount == 0 || objectCount > 0x7FFFFFFF) {
+        return false;
+    }
+
+    // Only the breadth first layout compact() writes is accepted: every node but the root is
+    // claimed by exactly one earlier parent, children and objects come in order without gaps or
+    // overlaps. That makes it a real tree, so each node's depth comes from its one parent and
+    // bounds the height the traversal stack has to hold.
+    std::vector<int> depth(nodeCount, 0);
+    uint64_t nextChild = 1;
+    uint64_t nextObject = 0;
+    for (size_t i = 0; i < nodeCount; i++) {
+        const PackedOctreeNode& node = nodes[i];
+        if (i > 0 && i >= nextChild) {
+            return false;
+        }
+        if (node.firstObject != nextObject || node.childCount > 8 || depth[i] >= kMaxHeight) {
+            return false;
+        }
+        nextObject += node.objectCount;
+        if (node.childCount > 0) {
+            if (node.firstChild != nextChild || nextChild + node.childCount > nodeCount) {
+                return false;
+            }
+            for (uint32_t c = 0; c < node.childCount; c++) {
+                depth[node.firstChild + c] = depth[i] + 1;
+            }
+            nextChild += node.childCount;
+        }
+    }
+    if (nextChild != nodeCount || nextObject != objectCount) {
+        return false;
+    }
+
+    clear();
+    m_packedBounds8 = std::vector<QuantizedBounds8>();
+    m_packedBounds16 = std::vector<QuantizedBounds16>();
+    m_compressed = true;
+    m_precision = precision;
+    m_packedNodes.assign(nodes, nodes + nodeCount);
+    m_packedObjects.assign(objects, objects + objectCount);
+    target.assign(bounds, bounds + objectCount);
+    m_objectCount = (int)objectCount;
+    m_compactValid = true;
+    m_treePending = objectCount > 0;
+    return true;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::compact() {
+    if (!m_compressed || (m_treePending && m_compactValid)) {
+        return;
+    }
+
+    m_packedNodes.clear();
+    m_packedObjects.clear();
+    m_packedBounds8.clear();
+    m_packedBounds16.clear();
+    m_packedObjects.reserve(m_objectCount);
+
+    // Every node once top down with where its 8 children start (0 for leaves), then once bottom
+    // up to total the objects below each node, so empty subtrees are skipped in a single pass
+    std::vector<const Node*> nodes;
+    std::vector<uint32_t> firstChild;
+    nodes.push_back(m_root);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node* node = nodes[i];
+        firstChild.push_back(0);
+        if (!node->isLeaf()) {
+            firstChild[i] = (uint32_t)nodes.size();
+            for (int c = 0; c < 8; c++) {
+                nodes.push_back(&node->children[c]);
+            }
+        }
+    }
+    // Objects the root could not grow to reach stick out of the node they were kept in, and later
+    // root growth can move that node down the tree. Quantizing against the node would clamp their
+    // bounds and an ancestor's node test could skip them, so the same pass widens every packed
+    // node to cover whatever sticks out of it or its children, with a little margin for the
+    // rounding of the steps. Non finite bounds can't be covered at all.
+    std::vector<int> totals(nodes.size());
+    std::vector<float> halfSizes(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const Node* node = nodes[i];
+        float halfSize = node->halfSize;
+        auto cover = [&](const glm::vec3& min, const glm::vec3& max) {
+            glm::vec3 reach = glm::max(glm::abs(min - node->center), glm::abs(max - node->center));
+            float needed = std::max(reach.x, std::max(reach.y, reach.z)) * 1.001f;
+            if (std::isfinite(needed) && needed > halfSize) {
+                halfSize = needed;
+            }
+        };
+        for (int j = 0; j < node->count; j++) {
+            if (!node->contains(node->items[j].bounds)) {
+                cover(node->items[j].bounds.min, node->items[j].bounds.max);
+            }
+        }
+        for (const Item& item : node->overflow) {
+            if (!node->contains(item.bounds)) {
+                cover(item.bounds.min, item.bounds.max);
+            }
+        }
+
+        totals[i] = node->objectCount();
+        if (firstChild[i] != 0) {
+            for (uint32_t c = firstChild[i]; c < firstChild[i] + 8; c++) {
+                totals[i] += totals[c];
+                if (halfSizes[c] > nodes[c]->halfSize) {
+                    cover(nodes[c]->center - glm::vec3(halfSizes[c]), nodes[c]->center + glm::vec3(halfSizes[c]));
+                }
+            }
+        }
+        halfSizes[i] = halfSize;
+    }
+
+    // Breadth first, so packed node i always belongs to nodes[queue[i]] and siblings end up adjacent
+    std::vector<uint32_t> queue;
+    queue.push_back(0);
+    m_packedNodes.push_back({m_root->center, halfSizes[0], 0, 0, 0, 0});
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        uint32_t index = queue[i];
+        const Node* node = nodes[index];
+
+        if (m_precision == OctreeBoundsPrecision::Bits8) {
+            packObjects((uint32_t)i, node, m_packedBounds8);
+        } else {
+            packObjects((uint32_t)i, node, m_packedBounds16);
+        }
+
+        if (firstChild[index] != 0) {
+            m_packedNodes[i].firstChild = (uint32_t)m_packedNodes.size();
+            for (uint32_t c = firstChild[index]; c < firstChild[index] + 8; c++) {
+                if (totals[c] == 0) {
+                    continue;
+                }
+
+                m_packedNodes.push_back({nodes[c]->center, halfSizes[c], 0, 0, 0, 0});
+                m_packedNodes[i].childCount++;
+                queue.push_back(c);
+            }
+        }
+    }
+
+    m_compactValid = true;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename Bounds>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::packObjects(uint32_t nodeIndex, const Node* node, std::vector<Bounds>& bounds) {
+    PackedOctreeNode& packed = m_packedNodes[nodeIndex];
+    packed.firstObject = (uint32_t)m_packedObjects.size();
+    packed.objectCount = (uint32_t)node->objectCount();
+
+    auto pack = [&](const Item& item) {
+        m_packedObjects.push_back(item.value);
+        bounds.push_back(quantizeBounds<Bounds>(packed, item.bounds));
+    };
+    for (int i = 0; i < node->count; i++) {
+        pack(node->items[i]);
+    }
+    for (const Item& item : node->overflow) {
+        pack(item);
+    }
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename NodeTest, typename ObjectTest, typename F>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::traverse(NodeTest& nodeTest, ObjectTest& objectTest, F& fn) const {
+    // Every pop pushes at most 8 children, so the stack never holds more than 7 per level plus one
+    const Node* stack[7 * kMaxHeight + 8];
+    int top = 0;
+    stack[top++] = m_root;
+
+    while (top > 0) {
+        const Node* node = stack[--top];
+        if (!nodeTest(node->center, node->halfSize)) {
+            continue;
+        }
+
+        for (int i = 0; i < node->count; i++) {
+            const Item& item = node->items[i];
+            if (objectTest(item.bounds, item.value) && !invokeVisitor(fn, item.value)) {
+                return false;
+            }
+        }
+        for (const Item& item : node->overflow) {
+            if (objectTest(item.bounds, item.value) && !invokeVisitor(fn, item.value)) {
+                return false;
+            }
+        }
+
+        if (!node->isLeaf()) {
+            for (int i = 7; i >= 0; i--) {
+                stack[top++] = &node->children[i];
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename Bounds, typename NodeTest, typename ObjectTest, typename F>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::traverseCompact(const std::vector<Bounds>& bounds, NodeTest& nodeTest,
+                                                                  ObjectTest& objectTest, F& fn) const {
+    uint32_t stack[7 * kMaxHeight + 8];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const PackedOctreeNode& node = m_packedNodes[stack[--top]];
+        if (!nodeTest(node.center, node.halfSize)) {
+            continue;
+        }
+
+        for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+            AABB loose;
+            dequantizeBounds(node, bounds[i], loose.min, loose.max);
+            if (objectTest(loose, m_packedObjects[i]) && !invokeVisitor(fn, m_packedObjects[i])) {
+                return false;
+            }
+        }
+
+        for (uint32_t c = node.childCount; c > 0; c--) {
+            stack[top++] = node.firstChild + c - 1;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename F>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::forEachInFrustum(const Frustum& frustum, F&& fn) const {
+    auto nodeTest = [&frustum](const glm::vec3& center, float halfSize) {
+        return frustum.isAABBVisible(center - glm::vec3(halfSize), center + glm::vec3(halfSize));
+    };
+
+    // Conservative in compressed mode: objects whose rounded bounds touch the frustum are visited
+    auto objectTest = [&frustum](const AABB& bounds, const T&) {
+        return frustum.isAABBVisible(bounds);
+    };
+
+    if (isCompactValid()) {
+        if (m_precision == OctreeBoundsPrecision::Bits8) {
+            traverseCompact(m_packedBounds8, nodeTest, objectTest, fn);
+        } else {
+            traverseCompact(m_packedBounds16, nodeTest, objectTest, fn);
+        }
+        return;
+    }
+
+    traverse(nodeTest, objectTest, fn);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename F>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::forEachInRange(const glm::vec3& center, float radius, F&& fn) const {
+    auto nodeTest = [&center, radius](const glm::vec3& nodeCenter, float halfSize) {
+        float nodeRadius = halfSize * 1.732f; // sqrt(3)
+        return glm::distance(nodeCenter, center) <= radius + nodeRadius;
+    };
+
+    if (isCompactValid()) {
+        // The object center lies inside its rounded bounds, so a sphere missing them misses the center too
+        float radiusSq = radius * radius;
+        auto objectTest = [this, &center, radius, radiusSq](const AABB& loose, const T& value) {
+            glm::vec3 offset = glm::clamp(center, loose.min, loose.max) - center;
+            if (glm::dot(offset, offset) > radiusSq) {
+                return false;
+            }
+            return glm::distance(m_boundsFn(value).center(), center) <= radius;
+        };
+
+        if (m_precision == OctreeBoundsPrecision::Bits8) {
+            traverseCompact(m_packedBounds8, nodeTest, objectTest, fn);
+        } else {
+            traverseCompact(m_packedBounds16, nodeTest, objectTest, fn);
+        }
+        return;
+    }
+
+    auto objectTest = [&center, radius](const AABB& bounds, const T&) {
+        return glm::distance(bounds.center(), center) <= radius;
+    };
+    traverse(nodeTest, objectTest, fn);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+template <typename F>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::forEachInAABB(const glm::vec3& min, const glm::vec3& max, F&& fn) const {
+    AABB query(min, max);
+    auto nodeTest = [&query](const glm::vec3& center, float halfSize) {
+        return query.overlaps(AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize)));
+    };
+
+    if (isCompactValid()) {
+        // Reject on the rounded bounds first, only overlaps pay for the exact test
+        auto objectTest = [this, &query](const AABB& loose, const T& value) {
+            return query.overlaps(loose) && query.overlaps(m_boundsFn(value));
+        };
+
+        if (m_precision == OctreeBoundsPrecision::Bits8) {
+            traverseCompact(m_packedBounds8, nodeTest, objectTest, fn);
+        } else {
+            traverseCompact(m_packedBounds16, nodeTest, objectTest, fn);
+        }
+        return;
+    }
+
+    auto objectTest = [&query](const AABB& bounds, const T&) {
+        return query.overlaps(bounds);
+    };
+    traverse(nodeTest, objectTest, fn);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::queryFrustum(const Frustum& frustum, std::vector<T>& result) const {
+    result.clear();
+    result.reserve(m_objectCount / 4);
+    forEachInFrustum(frustum, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::queryRange(const glm::vec3& center, float radius, std::vector<T>& result) const {
+    result.clear();
+    forEachInRange(center, radius, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+void Octree<T, BoundsFn, MaxDepth, LeafCapacity>::queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<T>& result) const {
+    result.clear();
+    forEachInAABB(min, max, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+bool Octree<T, BoundsFn, MaxDepth, LeafCapacity>::raycast(const glm::vec3& origin, const glm::vec3& direction,
+                                                          float maxDistance, T* hit) const {
+    glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float closestDist = maxDistance;
+    bool found = false;
+
+    // Nodes are pruned against the closest hit so far, which shrinks as the walk goes on
+    auto nodeTest = [&](const glm::vec3& center, float halfSize) {
+        float t;
+        return rayHitsAABB(origin, invDir, center - glm::vec3(halfSize), center + glm::vec3(halfSize), closestDist, t);
+    };
+    auto objectTest = [&](const AABB& bounds, const T&) {
+        float t;
+        if (rayHitsAABB(origin, invDir, bounds.min, bounds.max, closestDist, t) && t < closestDist) {
+            closestDist = t;
+            return true;
+        }
+        return false;
+    };
+    auto recordHit = [hit, &found](const T& value) {
+        *hit = value;
+        found = true;
+    };
+
+    if (isCompactValid()) {
+        // The rounded bounds only prune, the hit distance comes from the exact bounds
+        auto compactTest = [&](const AABB& loose, const T& value) {
+            float t;
+            if (!rayHitsAABB(origin, invDir, loose.min, loose.max, closestDist, t)) {
+                return false;
+            }
+            AABB exact = m_boundsFn(value);
+            return objectTest(exact, value);
+        };
+
+        if (m_precision == OctreeBoundsPrecision::Bits8) {
+            traverseCompact(m_packedBounds8, nodeTest, compactTest, recordHit);
+        } else {
+            traverseCompact(m_packedBounds16, nodeTest, compactTest, recordHit);
+        }
+        return found;
+    }
+
+    traverse(nodeTest, objectTest, recordHit);
+    return found;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getNodeCount() const {
+    if (m_treePending) {
+        return (int)m_packedNodes.size();
+    }
+    return getNodeCountRecursive(m_root);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getNodeCountRecursive(const Node* node) const {
+    int count = 1;
+    if (!node->isLeaf()) {
+        for (int i = 0; i < 8; i++) {
+            count += getNodeCountRecursive(&node->children[i]);
+        }
+    }
+    return count;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getDepth() const {
+    if (m_treePending) {
+        // Children always come after their parent in the packed order
+        std::vector<int> depths(m_packedNodes.size(), 0);
+        int depth = 0;
+        for (size_t i = 0; i < m_packedNodes.size(); i++) {
+            const PackedOctreeNode& node = m_packedNodes[i];
+            for (uint32_t c = 0; c < node.childCount; c++) {
+                depths[node.firstChild + c] = depths[i] + 1;
+            }
+            depth = std::max(depth, depths[i]);
+        }
+        return depth;
+    }
+    return getDepthRecursive(m_root);
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+int Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getDepthRecursive(const Node* node) const {
+    int depth = 0;
+    if (!node->isLeaf()) {
+        for (int i = 0; i < 8; i++) {
+            depth = std::max(depth, 1 + getDepthRecursive(&node->children[i]));
+        }
+    }
+    return depth;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+OctreeMemoryStats Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getMemoryStats() const {
+    OctreeMemoryStats stats;
+    stats.objectCount = m_objectCount;
+    stats.treeBytes = getTreeBytesRecursive(m_root);
+
+    if (isCompactValid()) {
+        stats.compactBytes = m_packedNodes.size() * sizeof(PackedOctreeNode) +
+                             m_packedObjects.size() * sizeof(T) +
+                             m_packedBounds8.size() * sizeof(QuantizedBounds8) +
+                             m_packedBounds16.size() * sizeof(QuantizedBounds16);
+    }
+    return stats;
+}
+
+template <typename T, typename BoundsFn, int MaxDepth, int LeafCapacity>
+size_t Octree<T, BoundsFn, MaxDepth, LeafCapacity>::getTreeBytesRecursive(const Node* node) const {
+    size_t bytes = sizeof(Node) + node->overflow.capacity() * sizeof(Item);
+    if (!node->isLeaf()) {
+        for (int i = 0; i < 8; i++) {
+            bytes += getTreeBytesRecursive(&node->children[i]);
+        }
+    }
+    return bytes;
+}
 
-    void insertRecursive(OctreeNode* node, Box* box, int depth);
-    bool removeRecursive(OctreeNode* node, Box* box);
-    void subdivide(OctreeNode* node);
-    void queryFrustumRecursive(OctreeNode* node, const Frustum& frustum, std::vector<Box*>& result) const;
-    void queryRangeRecursive(OctreeNode* node, const glm::vec3& center, float radius, std::vector<Box*>& result) const;
-    void queryAABBRecursive(OctreeNode* node, const glm::vec3& min, const glm::vec3& max, std::vector<Box*>& result) const;
-    bool raycastRecursive(OctreeNode* node, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Box** hitBox, float& closestDist) const;
-    int getNodeCountRecursive(OctreeNode* node) const;
-};
\ No newline at end of file
+// The scene's box index, instantiated once in Octree.cpp
+extern template class Octree<Box*, BoxBounds>;
+using BoxOctree = Octree<Box*, BoxBounds>;
@@ -1,72 +1,248 @@
 #include "Scene.h"
+#include "SceneFile.h"
 #include "../graphics/Renderer.h"
 #include <iostream>
 #include <algorithm>
 
+template class Octree<EntityHandle, EntityBounds>;
+template class SpatialHashGrid<EntityHandle, EntityBounds>;
+
+namespace {
+
+// Rows per culling job, smaller scenes are not worth splitting
+const size_t kParallelCullRows = 16384;
+
+// Section order is nodes, objects, bounds for both octrees
+SceneSection objectsOf(SceneSection nodes) { return (SceneSection)((uint32_t)nodes + 1); }
+SceneSection boundsOf(SceneSection nodes) { return (SceneSection)((uint32_t)nodes + 2); }
+
+uint32_t addOctreeSections(SceneFileWriter& writer, const EntityOctree& octree, SceneSection nodes) {
+    if (!octree.isCompactValid()) {
+        return 0;
+    }
+
+    writer.addSection(nodes, octree.getPackedNodes());
+    writer.addSection(objectsOf(nodes), octree.getPackedObjects());
+    if (octree.getBoundsPrecision() == OctreeBoundsPrecision::Bits8) {
+        writer.addSection(boundsOf(nodes), octree.getPackedBounds8());
+        return 8;
+    }
+    writer.addSection(boundsOf(nodes), octree.getPackedBounds16());
+    return 16;
+}
+
+// The saved index is only used when it holds exactly the live entities of its kind
+bool loadOctreeSections(const SceneFileReader& reader, EntityOctree& octree, SceneSection nodes, uint32_t precision,
+                        const EntityStorage& entities, size_t expected, bool isStatic) {
+    size_t nodeCount, objectCount, boundsCount = 0;
+    const PackedOctreeNode* packedNodes = reader.section<PackedOctreeNode>(nodes, nodeCount);
+    const EntityHandle* objects = reader.section<EntityHandle>(objectsOf(nodes), objectCount);
+    if (!packedNodes || !objects || objectCount != expected) {
+        return false;
+    }
+
+    for (size_t i = 0; i < objectCount; i++) {
+        int index = entities.indexOf(objects[i]);
+        if (index < 0 || entities.isStaticAt(index) != isStatic) {
+            return false;
+        }
+    }
+
+    if (precision == 8) {
+        const QuantizedBounds8* bounds = reader.section<QuantizedBounds8>(boundsOf(nodes), boundsCount);
+        return bounds && boundsCount == objectCount && octree.loadCompact(packedNodes, nodeCount, objects, objectCount, bounds);
+    }
+    const QuantizedBounds16* bounds = reader.section<QuantizedBounds16>(boundsOf(nodes), boundsCount);
+    return bounds && boundsCount == objectCount && octree.loadCompact(packedNodes, nodeCount, objects, objectCount, bounds);
+}
+
+}
+
 Scene::Scene(const std::string& name)
     : m_name(name),
+      m_projectionMatrix(1.0f),
+      m_spatialIndex(SpatialIndexType::Octree),
+      m_terrain(nullptr),
+      m_streamer(nullptr),
+      m_jobs(nullptr),
       m_useFrustumCulling(true),
       m_useBatchRendering(true),
       m_useOctree(true),
       m_overrideFrustumCulling(false),
       m_overrideBatchRendering(false),
-      m_overrideOctree(false)
+      m_overrideOctree(false),
+      m_sortInterval(0),
+      m_updatesSinceSort(0),
+      m_layoutChanged(false)
 {
-    m_octree = new Octree(glm::vec3(0.0f, 0.0f, 0.0f), 100.0f, 5, 8);
-    m_batchRenderer = new BatchRenderer();
+    m_octree = new EntityOctree(glm::vec3(0.0f, 0.0f, 0.0f), 100.0f, EntityBounds(&m_entities));
+    m_hashGrid = new EntityHashGrid(EntityBounds(&m_entities));
+    m_staticOctree = new EntityOctree(glm::vec3(0.0f, 0.0f, 0.0f), 100.0f, EntityBounds(&m_entities));
+    m_staticOctree->setCompressed(true, OctreeBoundsPrecision::Bits16);
+    m_staticGeometry = new StaticGeometry();
 }
 
 Scene::~Scene() {
+    // Stops the workers before anything they could be waiting on goes away
+    delete m_streamer;
     delete m_octree;
-    delete m_batchRenderer;
+    delete m_hashGrid;
+    delete m_staticOctree;
+    delete m_staticGeometry;
+    delete m_terrain;
+}
 
-    for (Box* box : m_ownedBoxes) {
-        delete box;
+Terrain* Scene::createTerrain(int cellsPerSide, float spacing, const glm::vec3& origin) {
+    delete m_terrain;
+    m_terrain = new Terrain(cellsPerSide, spacing, origin);
+    return m_terrain;
+}
+
+void Scene::removeTerrain() {
+    delete m_terrain;
+    m_terrain = nullptr;
+}
+
+WorldStreamer* Scene::createStreamer(float cellSize, const StreamCellLoader& loader, int workerCount) {
+    removeStreamer();
+    m_streamer = new WorldStreamer(this, cellSize, loader, workerCount);
+    return m_streamer;
+}
+
+void Scene::removeStreamer() {
+    if (m_streamer) {
+        m_streamer->unloadAll();
+        delete m_streamer;
+        m_streamer = nullptr;
     }
 }
 
-void Scene::addEntity(Box* box) {
-    m_boxes.push_back(box);
-    if (m_useOctree) {
-        m_octree->insert(box);
+EntityHandle Scene::addEntity(const Box& box) {
+    return createRect(box.position, box.size);
+}
+
+EntityHandle Scene::createRect(const glm::vec3& position, const glm::vec3& size, bool isStatic) {
+    EntityHandle entity = m_entities.create(position, size, isStatic);
+    m_layoutChanged = true;
+    if (isStatic) {
+        m_staticGeometry->add(entity, position);
     }
+    indexInsert(entity, isStatic);
+    return entity;
+}
+
+EntityHandle Scene::createRect(const glm::vec3& position, float size, bool isStatic) {
+    return createRect(position, glm::vec3(size, size, size), isStatic);
 }
 
-Box* Scene::createRect(const glm::vec3& position, const glm::vec3& size) {
-    Box* box = new Box(position, size);
-    m_ownedBoxes.push_back(box);
-    addEntity(box);
-    return box;
+void Scene::indexInsert(EntityHandle entity, bool isStatic) {
+    if (!m_useOctree) {
+        return;
+    }
+
+    if (isStatic) {
+        m_staticOctree->insert(entity);
+    } else if (m_spatialIndex == SpatialIndexType::HashGrid) {
+        m_hashGrid->insert(entity);
+    } else {
+        m_octree->insert(entity);
+    }
 }
 
-Box* Scene::createRect(const glm::vec3& position, float size) {
-    return createRect(position, glm::vec3(size, size, size));
+void Scene::indexRemove(EntityHandle entity, const AABB& bounds, bool isStatic) {
+    if (!m_useOctree) {
+        return;
+    }
+
+    if (isStatic) {
+        m_staticOctree->remove(entity, bounds);
+    } else if (m_spatialIndex == SpatialIndexType::HashGrid) {
+        m_hashGrid->remove(entity, bounds);
+    } else {
+        m_octree->remove(entity, bounds);
+    }
 }
 
-void Scene::removeEntity(Box* box) {
-    auto it = std::find(m_boxes.begin(), m_boxes.end(), box);
-    if (it != m_boxes.end()) {
-        m_boxes.erase(it);
-        if (m_useOctree) {
-            m_octree->remove(box);
+void Scene::createRects(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& sizes,
+                        std::vector<EntityHandle>* created, bool isStatic) {
+    size_t count = positions.size();
+    if (sizes.size() != count) {
+        std::cerr << "Scene::createRects: got " << positions.size() << " positions but " << sizes.size()
+                  << " sizes, creating " << std::min(positions.size(), sizes.size()) << " boxes\n";
+        count = std::min(positions.size(), sizes.size());
+    }
+
+    // Grows geometrically, an exact reserve would copy every column on each small batch
+    if (m_entities.size() + count > m_entities.capacity()) {
+        m_entities.reserve(std::max(m_entities.size() + count, m_entities.size() * 2));
+    }
+    m_layoutChanged = true;
+    std::vector<EntityHandle> entities;
+    entities.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        entities.push_back(m_entities.create(positions[i], sizes[i], isStatic));
+        if (isStatic) {
+            m_staticGeometry->add(entities.back(), positions[i]);
+        }
+    }
+
+    if (m_useOctree) {
+        if (isStatic) {
+            m_staticOctree->insert(entities);
+        } else if (m_spatialIndex == SpatialIndexType::HashGrid) {
+            m_hashGrid->insert(entities);
+        } else {
+            m_octree->insert(entities);
         }
     }
 
-    auto ownedIt = std::find(m_ownedBoxes.begin(), m_ownedBoxes.end(), box);
-    if (ownedIt != m_ownedBoxes.end()) {
-        m_ownedBoxes.erase(ownedIt);
-        delete box;
+    if (created) {
+        created->insert(created->end(), entities.begin(), entities.end());
     }
 }
 
+void Scene::removeEntity(EntityHandle entity) {
+    int index = m_entities.indexOf(entity);
+    if (index < 0) {
+        return;
+    }
+
+    // Leave the index first, its bounds lookups go through the storage
+    AABB bounds = m_entities.unchangedBounds(index);
+    bool isStatic = m_entities.isStaticAt(index);
+    indexRemove(entity, bounds, isStatic);
+    if (isStatic) {
+        m_staticGeometry->remove(entity, bounds.center());
+    }
+    m_entities.destroy(entity);
+    m_layoutChanged = true;
+}
+
+glm::vec3 Scene::getPosition(EntityHandle entity) const {
+    int index = m_entities.indexOf(entity);
+    return index >= 0 ? m_entities.getPositions()[index] : glm::vec3(0.0f);
+}
+
+glm::vec3 Scene::getSize(EntityHandle entity) const {
+    int index = m_entities.indexOf(entity);
+    return index >= 0 ? m_entities.getSizes()[index] : glm::vec3(0.0f);
+}
+
 void Scene::clear() {
-    m_boxes.clear();
+    if (m_streamer) {
+        m_streamer->reset();
+    }
+    m_entities.clear();
     m_octree->clear();
+    m_hashGrid->clear();
+    m_staticOctree->clear();
+    m_staticGeometry->clear();
+}
 
-    for (Box* box : m_ownedBoxes) {
-        delete box;
-    }
-    m_ownedBoxes.clear();
+void Scene::sortEntities() {
+    m_entities.sortSpatially();
+    m_layoutChanged = false;
+    m_updatesSinceSort = 0;
 }
 
 void Scene::inheritSettings(bool frustumCulling, bool batchRendering, bool octree) {
@@ -77,73 +253,357 @@ void Scene::inheritSettings(bool frustumCulling, bool batchRendering, bool octre
         m_useBatchRendering = batchRendering;
     }
     if (!m_overrideOctree) {
-        m_useOctree = octree;
+        setOctreeEnabled(octree);
     }
 }
 
+void Scene::setOctreeEnabled(bool enable) {
+    bool wasEnabled = m_useOctree;
+    m_useOctree = enable;
+    if (enable && !wasEnabled) {
+        rebuildOctree();
+    }
+}
+
+void Scene::setSpatialIndex(SpatialIndexType type) {
+    if (type == m_spatialIndex) {
+        return;
+    }
+
+    m_spatialIndex = type;
+    if (type == SpatialIndexType::HashGrid) {
+        m_octree->clear();
+    } else {
+        m_hashGrid->clear();
+    }
+    rebuildOctree();
+}
+
+// Rebuilds whichever spatial index the scene currently uses
 void Scene::rebuildOctree() {
-    m_octree->rebuild(m_boxes);
+    std::vector<EntityHandle> entities;
+    std::vector<EntityHandle> staticEntities;
+    entities.reserve(m_entities.size());
+    for (size_t i = 0; i < m_entities.size(); i++) {
+        if (m_entities.isStaticAt(i)) {
+            staticEntities.push_back(m_entities.handleAt(i));
+        } else {
+            entities.push_back(m_entities.handleAt(i));
+        }
+    }
+
+    if (m_spatialIndex == SpatialIndexType::HashGrid) {
+        m_hashGrid->rebuild(entities);
+    } else {
+        m_octree->rebuild(entities);
+    }
+    m_staticOctree->rebuild(staticEntities);
+    m_entities.clearChanges();
 }
 
-void Scene::updateFrustum(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
-    m_frustum.update(projectionMatrix, viewMatrix);
+bool Scene::saveToFile(const std::string& path) {
+    flushChanges();
+    if (m_useOctree && m_staticOctree->isCompressed()) {
+        m_staticOctree->compact();
+    }
+    if (m_useOctree && m_spatialIndex == SpatialIndexType::Octree && m_octree->isCompressed()) {
+        m_octree->compact();
+    }
+
+    std::vector<uint32_t> generations(m_entities.slotCount());
+    for (size_t i = 0; i < generations.size(); i++) {
+        generations[i] = m_entities.generationAt(i);
+    }
+
+    SceneFileWriter writer;
+    writer.addSection(SceneSection::Positions, m_entities.getPositions());
+    writer.addSection(SceneSection::Sizes, m_entities.getSizes());
+    writer.addSection(SceneSection::StaticFlags, m_entities.getStaticFlags());
+    writer.addSection(SceneSection::RowSlots, m_entities.getRowSlots());
+    writer.addSection(SceneSection::Generations, generations);
+
+    SceneFileHeader header = {};
+    header.spatialIndex = (uint32_t)m_spatialIndex;
+    if (m_useOctree) {
+        header.staticPrecision = addOctreeSections(writer, *m_staticOctree, SceneSection::StaticNodes);
+        if (m_spatialIndex == SpatialIndexType::Octree) {
+            header.dynamicPrecision = addOctreeSections(writer, *m_octree, SceneSection::DynamicNodes);
+        }
+    }
+    return writer.write(path, header);
 }
 
-void Scene::update(FlyCamera* camera, const glm::mat4& projectionMatrix) {
-    if (camera) {
-        updateFrustum(projectionMatrix, camera->getViewMatrix());
+bool Scene::loadFromFile(const std::string& path) {
+    SceneFileReader reader;
+    if (!reader.open(path)) {
+        return false;
     }
+
+    clear();
+    size_t count, sizeCount, flagCount, rowCount, slotCount;
+    const glm::vec3* positions = reader.section<glm::vec3>(SceneSection::Positions, count);
+    const glm::vec3* sizes = reader.section<glm::vec3>(SceneSection::Sizes, sizeCount);
+    const uint8_t* flags = reader.section<uint8_t>(SceneSection::StaticFlags, flagCount);
+    const uint32_t* rowSlots = reader.section<uint32_t>(SceneSection::RowSlots, rowCount);
+    const uint32_t* generations = reader.section<uint32_t>(SceneSection::Generations, slotCount);
+    if (!positions || !sizes || !flags || !rowSlots || !generations ||
+        sizeCount != count || flagCount != count || rowCount != count ||
+        !m_entities.load(positions, sizes, flags, rowSlots, count, generations, slotCount)) {
+        std::cerr << path << " has broken entity data" << std::endl;
+        clear();
+        return false;
+    }
+
+    const SceneFileHeader& header = reader.getHeader();
+    m_spatialIndex = header.spatialIndex == (uint32_t)SpatialIndexType::HashGrid
+        ? SpatialIndexType::HashGrid : SpatialIndexType::Octree;
+
+    std::vector<EntityHandle> entities;
+    std::vector<EntityHandle> staticEntities;
+    for (size_t i = 0; i < m_entities.size(); i++) {
+        if (m_entities.isStaticAt(i)) {
+            staticEntities.push_back(m_entities.handleAt(i));
+            m_staticGeometry->add(staticEntities.back(), m_entities.getPositions()[i]);
+        } else {
+            entities.push_back(m_entities.handleAt(i));
+        }
+    }
+
+    // Saved octrees are taken as they are, anything missing is built from the entities
+    if (m_useOctree) {
+        if (!loadOctreeSections(reader, *m_staticOctree, SceneSection::StaticNodes, header.staticPrecision,
+                                m_entities, staticEntities.size(), true)) {
+            m_staticOctree->insert(staticEntities);
+        }
+        if (m_spatialIndex == SpatialIndexType::HashGrid) {
+            m_hashGrid->insert(entities);
+        } else if (!loadOctreeSections(reader, *m_octree, SceneSection::DynamicNodes, header.dynamicPrecision,
+                                       m_entities, entities.size(), false)) {
+            m_octree->insert(entities);
+        }
+    }
+
+    m_layoutChanged = true;
+    return true;
 }
 
-void Scene::renderScene(Renderer* renderer, FlyCamera* camera) {
-    m_stats.reset();
-    m_stats.totalEntities = m_boxes.size();
+// Moves every changed entity from its old bounds to its current ones
+void Scene::flushChanges() {
+    const std::vector<EntityChange>& changes = m_entities.getChanges();
+    if (changes.empty()) {
+        return;
+    }
 
-    std::vector<Box*> visibleBoxes;
+    // Static chunks follow their entities whether or not an index is kept
+    for (const EntityChange& change : changes) {
+        int index = m_entities.indexOf(change.entity);
+        if (index >= 0 && m_entities.isStaticAt(index)) {
+            m_staticGeometry->move(change.entity, change.oldBounds.center(), m_entities.getPositions()[index]);
+        }
+    }
 
-    if (m_useOctree && m_useFrustumCulling) {
-        m_octree->queryFrustum(m_frustum, visibleBoxes);
-        m_stats.frustumCulled = m_stats.totalEntities - visibleBoxes.size();
-    } else if (m_useFrustumCulling) {
-        visibleBoxes.reserve(m_boxes.size() / 2);
-        for (auto box : m_boxes) {
-            if (m_frustum.isBoxVisible(box)) {
-                visibleBoxes.push_back(box);
-            }
+    if (!m_useOctree) {
+        m_entities.clearChanges();
+        return;
+    }
+
+    // When most of the scene moved a rebuild is cheaper than moving them one by one
+    if (changes.size() > m_entities.size() / 4) {
+        rebuildOctree();
+        return;
+    }
+
+    for (const EntityChange& change : changes) {
+        int index = m_entities.indexOf(change.entity);
+        if (index < 0) {
+            continue;
         }
-        m_stats.frustumCulled = m_stats.totalEntities - visibleBoxes.size();
+
+        bool isStatic = m_entities.isStaticAt(index);
+        indexRemove(change.entity, change.oldBounds, isStatic);
+        indexInsert(change.entity, isStatic);
+    }
+    m_entities.clearChanges();
+}
+
+void Scene::queryRange(const glm::vec3& center, float radius, std::vector<EntityHandle>& result) const {
+    if (m_spatialIndex == SpatialIndexType::HashGrid) {
+        m_hashGrid->queryRange(center, radius, result);
     } else {
-        // No culling
-        visibleBoxes = m_boxes;
-        m_stats.frustumCulled = 0;
+        m_octree->queryRange(center, radius, result);
     }
+    m_staticOctree->forEachInRange(center, radius, [&result](EntityHandle entity) { result.push_back(entity); });
+}
 
-    m_stats.rendered = visibleBoxes.size();
+void Scene::queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<EntityHandle>& result) const {
+    if (m_spatialIndex == SpatialIndexType::HashGrid) {
+        m_hashGrid->queryAABB(min, max, result);
+    } else {
+        m_octree->queryAABB(min, max, result);
+    }
+    m_staticOctree->forEachInAABB(min, max, [&result](EntityHandle entity) { result.push_back(entity); });
+}
 
-    if (m_useBatchRendering) {
-        m_batchRenderer->beginBatch();
+bool Scene::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, EntityHandle* hit) const {
+    *hit = EntityHandle();
 
-        glm::vec3 cameraPos = glm::vec3(0.0f);
-        if (camera) {
-            cameraPos = camera->getPosition();
+    // The static hit caps the distance for the dynamic ray, a closer dynamic hit wins
+    EntityHandle staticHit;
+    if (m_staticOctree->raycast(origin, direction, maxDistance, &staticHit)) {
+        int index = m_entities.indexOf(staticHit);
+        if (index >= 0) {
+            AABB bounds = m_entities.boundsAt(index);
+            glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+            float t;
+            if (rayHitsAABB(origin, invDir, bounds.min, bounds.max, maxDistance, t)) {
+                maxDistance = t;
+            }
+            *hit = staticHit;
         }
+    }
 
-        for (auto box : visibleBoxes) {
+    EntityHandle dynamicHit;
+    bool found = m_spatialIndex == SpatialIndexType::HashGrid
+        ? m_hashGrid->raycast(origin, direction, maxDistance, &dynamicHit)
+        : m_octree->raycast(origin, direction, maxDistance, &dynamicHit);
+    if (found) {
+        *hit = dynamicHit;
+    }
+    return !hit->isNull();
+}
+
+void Scene::updateFrustum(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
+    m_frustum.update(projectionMatrix, viewMatrix);
+}
+
+void Scene::update(FlyCamera* camera, const glm::mat4& projectionMatrix) {
+    m_projectionMatrix = projectionMatrix;
+
+    if (m_streamer && camera) {
+        m_streamer->update(camera->getPosition());
+    }
+
+    // Before the commit and compact below, they pick up what the flush changed
+    if (!m_entities.getChanges().empty()) {
+        m_layoutChanged = true;
+    }
+    flushChanges();
+
+    if (m_sortInterval > 0 && ++m_updatesSinceSort >= m_sortInterval) {
+        m_updatesSinceSort = 0;
+        if (m_layoutChanged) {
+            sortEntities();
+        }
+    }
+
+    if (m_useOctree && m_hashGrid->hasPending()) {
+        m_hashGrid->commit();
+    }
+
+    // Repacking while cells stream in would cost a full pass every frame, the pointer tree
+    // answers queries until streaming settles
+    bool streaming = m_streamer && m_streamer->isIntegrating();
+    if (m_useOctree && !streaming && m_octree->isCompressed() && !m_octree->isCompactValid()) {
+        m_octree->compact();
+    }
+    if (m_useOctree && !streaming && m_staticOctree->isCompressed() && !m_staticOctree->isCompactValid()) {
+        m_staticOctree->compact();
+    }
+}
+
+void Scene::buildRenderPacket(RenderPacket& packet, FlyCamera* camera, FrameArena& arena, float alpha) {
+    m_stats.reset();
+    m_stats.totalEntities = (int)m_entities.size();
+
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    packet.projection = m_projectionMatrix;
+    if (camera) {
+        cameraPos = camera->getInterpolatedPosition(alpha);
+        packet.view = camera->getInterpolatedViewMatrix(alpha);
+        updateFrustum(m_projectionMatrix, packet.view);
+    }
+
+    const std::vector<glm::vec3>& positions = m_entities.getPositions();
+    const std::vector<glm::vec3>& sizes = m_entities.getSizes();
+
+    // Visible rows go straight into the packet, no per frame visibility list
+    auto drawVisible = [&](size_t index) {
+        m_stats.rendered++;
+
+        if (m_useBatchRendering) {
             LODLevel lod = LODLevel::HIGH;
             if (camera) {
-                lod = m_lodSystem.calculateLOD(box->position, cameraPos);
+                lod = m_lodSystem.calculateLOD(positions[index], cameraPos);
             }
-            m_batchRenderer->addInstance(box, lod, cameraPos);
+            packet.addInstance(positions[index], sizes[index], lod);
+        } else {
+            packet.boxes.push_back({positions[index], sizes[index]});
         }
+    };
+    auto drawEntity = [&](EntityHandle entity) {
+        int index = m_entities.indexOf(entity);
+        if (index >= 0) {
+            drawVisible((size_t)index);
+        }
+    };
 
-        m_batchRenderer->endBatch();
+    if (m_useOctree && m_useFrustumCulling) {
+        if (m_spatialIndex == SpatialIndexType::HashGrid) {
+            m_hashGrid->forEachInFrustum(m_frustum, drawEntity);
+        } else {
+            m_octree->forEachInFrustum(m_frustum, drawEntity);
+        }
+    } else if (m_useFrustumCulling && m_jobs && positions.size() > kParallelCullRows) {
+        // The tests run as jobs, each range writes its visible rows to its own slice of the
+        // array and the packet is filled here in row order
+        size_t ranges = (positions.size() + kParallelCullRows - 1) / kParallelCullRows;
+        FrameVector<uint32_t> visible(positions.size(), FrameAllocator<uint32_t>(arena));
+        FrameVector<uint32_t> visibleCounts(ranges, FrameAllocator<uint32_t>(arena));
+        m_jobs->parallelFor(positions.size(), kParallelCullRows, [&](size_t begin, size_t end) {
+            uint32_t count = 0;
+            for (size_t i = begin; i < end; i++) {
+                if (!m_entities.isStaticAt(i) && m_frustum.isAABBVisible(AABB::fromCenterSize(positions[i], sizes[i]))) {
+                    visible[begin + count++] = (uint32_t)i;
+                }
+            }
+            visibleCounts[begin / kParallelCullRows] = count;
+        });
+        for (size_t range = 0; range < ranges; range++) {
+            size_t begin = range * kParallelCullRows;
+            for (size_t i = begin; i < begin + visibleCounts[range]; i++) {
+                drawVisible(visible[i]);
+            }
+        }
+    } else if (m_useFrustumCulling) {
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (!m_entities.isStaticAt(i) && m_frustum.isAABBVisible(AABB::fromCenterSize(positions[i], sizes[i]))) {
+                drawVisible(i);
+            }
+        }
     } else {
-        for (auto box : visibleBoxes) {
-            renderer->drawBox(box);
+        // No culling
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (!m_entities.isStaticAt(i)) {
+                drawVisible(i);
+            }
         }
     }
+
+    if (m_terrain) {
+        m_stats.terrainChunks = m_terrain->draw(m_useFrustumCulling ? &m_frustum : nullptr, cameraPos, packet);
+    }
+
+    // Static chunks skip the per entity path entirely
+    m_stats.rendered += m_staticGeometry->draw(m_entities, m_useFrustumCulling ? &m_frustum : nullptr,
+                                               m_useBatchRendering && camera ? &m_lodSystem : nullptr, cameraPos, packet);
+
+    m_stats.frustumCulled = m_stats.totalEntities - m_stats.rendered;
 }
 
 void Scene::render(Renderer* renderer, FlyCamera* camera) {
-    renderScene(renderer, camera);
+    RenderPacket packet;
+    FrameArena arena;
+    buildRenderPacket(packet, camera, arena);
+    MeshCache::takeReleased(packet.releases);
+    renderer->submit(packet, arena);
 }
\ No newline at end of file
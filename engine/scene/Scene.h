@@ -3,48 +3,114 @@
 #include <string>
 #include <glm/glm.hpp>
 #include "Box.h"
+#include "EntityStorage.h"
 #include "../graphics/Frustum.h"
 #include "../systems/LODSystem.h"
 #include "Octree.h"
-#include "../graphics/BatchRenderer.h"
+#include "SpatialHashGrid.h"
+#include "../graphics/RenderPacket.h"
+#include "../graphics/StaticGeometry.h"
 #include "../components/FlyCamera.h"
+#include "../components/Terrain.h"
+#include "WorldStreamer.h"
+#include "../core/JobSystem.h"
+#include "../core/FrameArena.h"
 
 struct CullingStats {
     int totalEntities = 0;
     int frustumCulled = 0;
     int rendered = 0;
+    int terrainChunks = 0;
 
     void reset() {
         totalEntities = 0;
         frustumCulled = 0;
         rendered = 0;
+        terrainChunks = 0;
     }
 };
 
+// The scene's spatial indices, instantiated once in Scene.cpp
+extern template class Octree<EntityHandle, EntityBounds>;
+extern template class SpatialHashGrid<EntityHandle, EntityBounds>;
+using EntityOctree = Octree<EntityHandle, EntityBounds>;
+using EntityHashGrid = SpatialHashGrid<EntityHandle, EntityBounds>;
+
+enum class SpatialIndexType {
+    Octree,
+    HashGrid
+};
+
 class Scene {
 public:
     Scene(const std::string& name);
     ~Scene();
 
-    void addEntity(Box* box);
-    Box* createRect(const glm::vec3& position, const glm::vec3& size);
-    Box* createRect(const glm::vec3& position, float size = 1.0f);
+    EntityHandle addEntity(const Box& box);
+    // Static entities are baked into chunks that are culled and drawn as a whole. They can still
+    // be moved, but that rebakes their chunk, so keep them for things that rarely change.
+    EntityHandle createRect(const glm::vec3& position, const glm::vec3& size, bool isStatic = false);
+    EntityHandle createRect(const glm::vec3& position, float size = 1.0f, bool isStatic = false);
+    // Creates positions.size() boxes at once, the spatial index is built in a single pass.
+    // Handles are appended to created when given.
+    void createRects(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& sizes,
+                     std::vector<EntityHandle>* created = nullptr, bool isStatic = false);
     void clear();
-    void removeEntity(Box* box);
+    void removeEntity(EntityHandle entity);
+
+    // One heightfield terrain per scene, creating a new one replaces the old one
+    Terrain* createTerrain(int cellsPerSide, float spacing, const glm::vec3& origin = glm::vec3(0.0f));
+    void removeTerrain();
+    Terrain* getTerrain() { return m_terrain; }
+
+    // Streams cells of entities in and out around the camera during update(). One streamer per
+    // scene, removing it also removes what it streamed in.
+    WorldStreamer* createStreamer(float cellSize, const StreamCellLoader& loader, int workerCount = 1);
+    void removeStreamer();
+    WorldStreamer* getStreamer() { return m_streamer; }
+
+    // Frustum tests without a spatial index are split into jobs on it, nullptr keeps them on
+    // the rendering thread
+    void setJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+
+    // Handles of removed entities are detected, the getters return zero vectors for them
+    bool isValid(EntityHandle entity) const { return m_entities.isAlive(entity); }
+    glm::vec3 getPosition(EntityHandle entity) const;
+    glm::vec3 getSize(EntityHandle entity) const;
+    // Moved or resized entities are synced into the spatial index on the next update()
+    void setPosition(EntityHandle entity, const glm::vec3& position) { m_entities.setPosition(entity, position); }
+    void setSize(EntityHandle entity, const glm::vec3& size) { m_entities.setSize(entity, size); }
 
     void enableFrustumCulling(bool enable) { m_useFrustumCulling = enable; m_overrideFrustumCulling = true; }
     void enableBatchRendering(bool enable) { m_useBatchRendering = enable; m_overrideBatchRendering = true; }
-    void enableOctree(bool enable) { m_useOctree = enable; m_overrideOctree = true; }
+    // The index is not kept up to date while off, turning it back on rebuilds it
+    void enableOctree(bool enable) { setOctreeEnabled(enable); m_overrideOctree = true; }
     void setLODSettings(const LODSettings& settings) { m_lodSystem.setSettings(settings); }
+    void setSpatialIndex(SpatialIndexType type);
+    // Puts entities that are close in space next to each other in memory, handles stay valid.
+    // With an interval the scene does it on its own every that many updates, if anything changed.
+    void sortEntities();
+    void setEntitySortInterval(int updates) { m_sortInterval = updates; }
 
+    // Index maintenance and streaming, Application calls it at the fixed update rate
     void update(FlyCamera* camera, const glm::mat4& projectionMatrix);
+    // Culls and fills the packet with what to draw, without GL calls so another thread can draw
+    // the previous packet meanwhile. Uses the projection of the last update() and the camera
+    // interpolated by alpha between its last two updates. Scratch memory comes from the arena.
+    void buildRenderPacket(RenderPacket& packet, FlyCamera* camera, FrameArena& arena, float alpha = 1.0f);
+    // Builds a packet and draws it right away, for callers without a render thread
     void render(class Renderer* renderer, FlyCamera* camera);
 
     const std::string& getName() const { return m_name; }
-    size_t getEntityCount() const { return m_boxes.size(); }
+    size_t getEntityCount() const { return m_entities.size(); }
     const CullingStats& getCullingStats() const { return m_stats; }
-    Octree* getOctree() { return m_octree; }
-    const std::vector<Box*>& getEntities() const { return m_boxes; }
+    EntityOctree* getOctree() { return m_octree; }
+    EntityHashGrid* getHashGrid() { return m_hashGrid; }
+    // Static entities are indexed here instead of the octree or hash grid above
+    EntityOctree* getStaticOctree() { return m_staticOctree; }
+    StaticGeometry* getStaticGeometry() { return m_staticGeometry; }
+    SpatialIndexType getSpatialIndex() const { return m_spatialIndex; }
+    const EntityStorage& getEntities() const { return m_entities; }
 
     void inheritSettings(bool frustumCulling, bool batchRendering, bool octree);
     bool usesFrustumCulling() const { return m_useFrustumCulling; }
@@ -53,15 +119,31 @@ public:
 
     void rebuildOctree();
 
+    // Binary snapshot of the entities and their spatial indices, see SceneFile.h. Loading replaces
+    // the scene's entities and keeps its settings. Terrain is not part of the file.
+    bool saveToFile(const std::string& path);
+    bool loadFromFile(const std::string& path);
+
+    // Spatial queries, answered by whichever index the scene uses
+    void queryRange(const glm::vec3& center, float radius, std::vector<EntityHandle>& result) const;
+    void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<EntityHandle>& result) const;
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, EntityHandle* hit) const;
+
 private:
     std::string m_name;
-    std::vector<Box*> m_boxes;
-    std::vector<Box*> m_ownedBoxes;
+    EntityStorage m_entities;
 
     Frustum m_frustum;
+    glm::mat4 m_projectionMatrix;
     LODSystem m_lodSystem;
-    Octree* m_octree;
-    BatchRenderer* m_batchRenderer;
+    EntityOctree* m_octree;
+    EntityHashGrid* m_hashGrid;
+    EntityOctree* m_staticOctree;
+    SpatialIndexType m_spatialIndex;
+    StaticGeometry* m_staticGeometry;
+    Terrain* m_terrain;
+    WorldStreamer* m_streamer;
+    JobSystem* m_jobs;
 
     CullingStats m_stats;
 
@@ -73,6 +155,13 @@ private:
     bool m_overrideBatchRendering;
     bool m_overrideOctree;
 
+    int m_sortInterval;
+    int m_updatesSinceSort;
+    bool m_layoutChanged;
+
+    void setOctreeEnabled(bool enable);
+    void indexInsert(EntityHandle entity, bool isStatic);
+    void indexRemove(EntityHandle entity, const AABB& bounds, bool isStatic);
+    void flushChanges();
     void updateFrustum(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix);
-    void renderScene(Renderer* renderer, FlyCamera* camera);
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "SceneFile.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'S', 'O', 'L', 'S', 'C', 'E', 'N', 'E'};
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + kSceneFileAlignment - 1) & ~(uint64_t)(kSceneFileAlignment - 1);
+}
+
+}
+
+void SceneFileWriter::addSection(SceneSection type, const void* data, size_t elementSize, size_t count) {
+    m_sections.push_back({{(uint32_t)type, (uint32_t)elementSize, 0, (uint64_t)count}, data});
+}
+
+bool SceneFileWriter::write(const std::string& path, const SceneFileHeader& header) const {
+    SceneFileHeader fileHeader = header;
+    std::memcpy(fileHeader.magic, kMagic, sizeof(kMagic));
+    fileHeader.version = kSceneFileVersion;
+    fileHeader.byteOrder = kSceneFileByteOrder;
+    fileHeader.sectionCount = (uint32_t)m_sections.size();
+
+    std::vector<SceneFileSection> table;
+    uint64_t offset = alignUp(sizeof(SceneFileHeader) + m_sections.size() * sizeof(SceneFileSection));
+    for (const Pending& pending : m_sections) {
+        SceneFileSection section = pending.section;
+        section.offset = offset;
+        table.push_back(section);
+        offset = alignUp(offset + section.elementSize * section.count);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    const char padding[kSceneFileAlignment] = {};
+    file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SceneFileSection));
+    uint64_t written = sizeof(fileHeader) + table.size() * sizeof(SceneFileSection);
+    for (size_t i = 0; i < table.size(); i++) {
+        file.write(padding, table[i].offset - written);
+        uint64_t bytes = table[i].elementSize * table[i].count;
+        file.write(static_cast<const char*>(m_sections[i].data), bytes);
+        written = table[i].offset + bytes;
+    }
+
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SceneFileReader::open(const std::string& path) {
+    if (!m_file.open(path)) {
+        return false;
+    }
+
+    const SceneFileHeader& header = getHeader();
+    bool valid = m_file.size() >= sizeof(SceneFileHeader) && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0;
+    if (!valid) {
+        std::cerr << path << " is not a scene file" << std::endl;
+    } else if (header.byteOrder != kSceneFileByteOrder) {
+        std::cerr << path << " was written on a machine with a different byte order" << std::endl;
+        valid = false;
+    } else if (header.version != kSceneFileVersion) {
+        std::cerr << path << " has scene file version " << header.version << ", expected "
+                  << kSceneFileVersion << std::endl;
+        valid = false;
+    } else if (header.sectionCount > (m_file.size() - sizeof(SceneFileHeader)) / sizeof(SceneFileSection)) {
+        std::cerr << path << " is truncated" << std::endl;
+        valid = false;
+    }
+
+    const SceneFileSection* table = reinterpret_cast<const SceneFileSection*>(m_file.data() + sizeof(SceneFileHeader));
+    for (uint32_t i = 0; valid && i < header.sectionCount; i++) {
+        const SceneFileSection& section = table[i];
+        uint64_t available = section.offset <= m_file.size() ? m_file.size() - section.offset : 0;
+        if (section.elementSize == 0 || section.offset % kSceneFileAlignment != 0 ||
+            section.count > available / section.elementSize) {
+            std::cerr << path << " has a broken section table" << std::endl;
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        m_file.close();
+    }
+    return valid;
+}
+
+const void* SceneFileReader::find(SceneSection type, size_t elementSize, size_t& count) const {
+    count = 0;
+    if (!m_file.isOpen()) {
+        return nullptr;
+    }
+
+    const SceneFileSection* table = reinterpret_cast<const SceneFileSection*>(m_file.data() + sizeof(SceneFileHeader));
+    for (uint32_t i = 0; i < getHeader().sectionCount; i++) {
+        if (table[i].type == (uint32_t)type) {
+            if (table[i].elementSize != elementSize) {
+                return nullptr;
+            }
+            count = (size_t)table[i].count;
+            return m_file.data() + table[i].offset;
+        }
+    }
+    return nullptr;
+}
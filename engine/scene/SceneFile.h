@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../core/MappedFile.h"
+
+// Binary scene file. A fixed header, a table of sections and then the sections themselves, each
+// a raw array aligned to kSceneFileAlignment so it can be used straight from a memory mapping.
+// Files are written in the byte order of the machine, readers reject files from the other one.
+//
+// Version 1 holds the entity columns and slot generations plus the packed static octree, and the
+// packed dynamic octree when the scene uses a compressed one.
+
+const uint32_t kSceneFileVersion = 1;
+const uint32_t kSceneFileByteOrder = 0x01020304;
+const size_t kSceneFileAlignment = 16;
+
+enum class SceneSection : uint32_t {
+    Positions = 1,
+    Sizes,
+    StaticFlags,
+    RowSlots,
+    Generations,
+    StaticNodes,
+    StaticObjects,
+    StaticBounds,
+    DynamicNodes,
+    DynamicObjects,
+    DynamicBounds
+};
+
+struct SceneFileHeader {
+    char magic[8];              // "SOLSCENE"
+    uint32_t version;
+    uint32_t byteOrder;         // kSceneFileByteOrder as written
+    uint32_t sectionCount;
+    uint32_t spatialIndex;      // SpatialIndexType of the scene
+    uint32_t staticPrecision;   // bits per bound of the static octree
+    uint32_t dynamicPrecision;  // same for the dynamic octree, 0 when it was not saved
+};
+
+struct SceneFileSection {
+    uint32_t type;
+    uint32_t elementSize;
+    uint64_t offset;            // from the start of the file
+    uint64_t count;
+};
+
+class SceneFileWriter {
+public:
+    // The data has to stay alive until write()
+    void addSection(SceneSection type, const void* data, size_t elementSize, size_t count);
+    template <typename T>
+    void addSection(SceneSection type, const std::vector<T>& values) {
+        addSection(type, values.data(), sizeof(T), values.size());
+    }
+
+    bool write(const std::string& path, const SceneFileHeader& header) const;
+
+private:
+    struct Pending {
+        SceneFileSection section;
+        const void* data;
+    };
+    std::vector<Pending> m_sections;
+};
+
+class SceneFileReader {
+public:
+    // Maps the file and checks the header and that every section lies inside it
+    bool open(const std::string& path);
+    void close() { m_file.close(); }
+
+    const SceneFileHeader& getHeader() const { return *reinterpret_cast<const SceneFileHeader*>(m_file.data()); }
+
+    // Pointer into the mapping, nullptr when the section is missing or its elements are not
+    // sizeof(T) bytes. count is set to 0 in that case.
+    template <typename T>
+    const T* section(SceneSection type, size_t& count) const {
+        return static_cast<const T*>(find(type, sizeof(T), count));
+    }
+
+private:
+    MappedFile m_file;
+
+    const void* find(SceneSection type, size_t elementSize, size_t& count) const;
+};
@@ -0,0 +1,3 @@
+#include "SpatialHashGrid.h"
+
+template class SpatialHashGrid<Box*, BoxBounds>;
@@ -0,0 +1,520 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "AABB.h"
+#include "Box.h"
+#include "SpatialQuery.h"
+#include "../graphics/Frustum.h"
+
+// A single occupied grid cell. Its objects live in m_objects[start, start + count).
+struct HashGridCell {
+    glm::ivec3 coord;
+    uint32_t start;
+    uint32_t count;
+};
+
+// Uniform spatial hash grid over any payload type, BoundsFn maps a payload to its AABB.
+// Every object is stored by value with its bounds in the cell that holds its center,
+// so cell bounds are loosened by the largest object half-extent when culling.
+// Works best for dense, evenly spread scenes of similar sized objects (terrain grids).
+template <typename T, typename BoundsFn>
+class SpatialHashGrid {
+public:
+    typedef SpatialItem<T> Item;
+
+    explicit SpatialHashGrid(const BoundsFn& boundsFn = BoundsFn());
+    ~SpatialHashGrid() = default;
+
+    void insert(const T& value);
+    // Bulk insert, merges the whole batch with one rebuild
+    void insert(const std::vector<T>& values);
+    // Same lookup rules as Octree::remove
+    bool remove(const T& value);
+    bool remove(const T& value, const AABB& insertedBounds);
+    void clear();
+    void rebuild(const std::vector<T>& values);
+
+    // Folds objects inserted since the last rebuild into the cell storage.
+    void commit();
+    bool hasPending() const { return !m_pending.empty(); }
+
+    // Allocation free queries, see Octree for the visitor rules
+    template <typename F>
+    void forEachInFrustum(const Frustum& frustum, F&& fn) const;
+    template <typename F>
+    void forEachInRange(const glm::vec3& center, float radius, F&& fn) const;
+    template <typename F>
+    void forEachInAABB(const glm::vec3& min, const glm::vec3& max, F&& fn) const;
+
+    void queryFrustum(const Frustum& frustum, std::vector<T>& result) const;
+    void queryRange(const glm::vec3& center, float radius, std::vector<T>& result) const;
+    void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<T>& result) const;
+
+    // Ray casting, hit is only written when something was hit
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, T* hit) const;
+
+    // Statistics
+    int getObjectCount() const { return m_objectCount; }
+    int getCellCount() const { return (int)m_cells.size(); }
+    float getCellSize() const { return m_cellSize; }
+
+    // Configuration, by default the cell size follows the median object size on rebuild
+    void setCellSize(float size);
+    void setAutoCellSize() { m_fixedCellSize = false; }
+
+private:
+    // Keeps far away or degenerate query bounds from overflowing the integer cell coords
+    static constexpr float kMaxCellCoord = 1073741824.0f; // 2^30
+
+    BoundsFn m_boundsFn;
+    float m_cellSize;
+    float m_inverseCellSize;
+    bool m_fixedCellSize;
+    glm::vec3 m_maxHalfExtent;
+    int m_objectCount;
+
+    std::vector<HashGridCell> m_cells;
+    std::vector<Item> m_objects;
+    std::vector<uint32_t> m_table; // open addressing, stores cell index + 1, 0 = empty slot
+    uint32_t m_tableMask;
+
+    std::vector<Item> m_pending;
+
+    glm::ivec3 cellCoord(const glm::vec3& position) const;
+    static uint32_t hashCoord(const glm::ivec3& coord);
+    int findCell(const glm::ivec3& coord) const;
+    uint32_t findOrAddCell(const glm::ivec3& coord);
+    void cellBounds(const HashGridCell& cell, glm::vec3& min, glm::vec3& max) const;
+    float chooseCellSize(const std::vector<Item>& items) const;
+    void rebuildItems(const std::vector<Item>& items);
+    bool removeFromCells(const T& value, const glm::vec3& center);
+
+    // Calls fn for every occupied cell in [lo, hi], stops early once fn returns false
+    template <typename Fn>
+    bool visitCells(const glm::ivec3& lo, const glm::ivec3& hi, Fn&& fn) const;
+};
+
+template <typename T, typename BoundsFn>
+SpatialHashGrid<T, BoundsFn>::SpatialHashGrid(const BoundsFn& boundsFn)
+    : m_boundsFn(boundsFn), m_cellSize(1.0f), m_inverseCellSize(1.0f), m_fixedCellSize(false),
+      m_maxHalfExtent(0.0f), m_objectCount(0), m_tableMask(0) {
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::setCellSize(float size) {
+    m_cellSize = std::max(size, 0.001f);
+    m_inverseCellSize = 1.0f / m_cellSize;
+    m_fixedCellSize = true;
+}
+
+template <typename T, typename BoundsFn>
+glm::ivec3 SpatialHashGrid<T, BoundsFn>::cellCoord(const glm::vec3& position) const {
+    glm::ivec3 coord;
+    for (int i = 0; i < 3; i++) {
+        float c = std::floor(position[i] * m_inverseCellSize);
+        c = std::min(std::max(c, -kMaxCellCoord), kMaxCellCoord);
+        coord[i] = (int)c;
+    }
+    return coord;
+}
+
+template <typename T, typename BoundsFn>
+uint32_t SpatialHashGrid<T, BoundsFn>::hashCoord(const glm::ivec3& coord) {
+    return ((uint32_t)coord.x * 73856093u) ^
+           ((uint32_t)coord.y * 19349663u) ^
+           ((uint32_t)coord.z * 83492791u);
+}
+
+template <typename T, typename BoundsFn>
+int SpatialHashGrid<T, BoundsFn>::findCell(const glm::ivec3& coord) const {
+    if (m_table.empty()) {
+        return -1;
+    }
+
+    uint32_t slot = hashCoord(coord) & m_tableMask;
+    while (m_table[slot] != 0) {
+        uint32_t index = m_table[slot] - 1;
+        if (m_cells[index].coord == coord) {
+            return (int)index;
+        }
+        slot = (slot + 1) & m_tableMask;
+    }
+    return -1;
+}
+
+template <typename T, typename BoundsFn>
+uint32_t SpatialHashGrid<T, BoundsFn>::findOrAddCell(const glm::ivec3& coord) {
+    uint32_t slot = hashCoord(coord) & m_tableMask;
+    while (m_table[slot] != 0) {
+        uint32_t index = m_table[slot] - 1;
+        if (m_cells[index].coord == coord) {
+            return index;
+        }
+        slot = (slot + 1) & m_tableMask;
+    }
+
+    m_cells.push_back({coord, 0, 0});
+    m_table[slot] = (uint32_t)m_cells.size();
+    return (uint32_t)m_cells.size() - 1;
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::cellBounds(const HashGridCell& cell, glm::vec3& min, glm::vec3& max) const {
+    glm::vec3 cellMin = glm::vec3(cell.coord) * m_cellSize;
+    min = cellMin - m_maxHalfExtent;
+    max = cellMin + glm::vec3(m_cellSize) + m_maxHalfExtent;
+}
+
+template <typename T, typename BoundsFn>
+float SpatialHashGrid<T, BoundsFn>::chooseCellSize(const std::vector<Item>& items) const {
+    std::vector<float> sizes;
+    sizes.reserve(items.size());
+    for (const Item& item : items) {
+        glm::vec3 size = item.bounds.size();
+        sizes.push_back(std::max(size.x, std::max(size.y, size.z)));
+    }
+
+    auto median = sizes.begin() + sizes.size() / 2;
+    std::nth_element(sizes.begin(), median, sizes.end());
+    return std::max(*median, 0.001f);
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::insert(const T& value) {
+    m_pending.push_back({value, m_boundsFn(value)});
+    m_objectCount++;
+
+    // Merge once the unsorted tail gets large, this keeps bulk inserts amortized linear
+    if (m_pending.size() > 64 + m_objects.size() / 4) {
+        commit();
+    }
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::insert(const std::vector<T>& values) {
+    m_pending.reserve(m_pending.size() + values.size());
+    for (const T& value : values) {
+        m_pending.push_back({value, m_boundsFn(value)});
+    }
+    m_objectCount += (int)values.size();
+    commit();
+}
+
+template <typename T, typename BoundsFn>
+bool SpatialHashGrid<T, BoundsFn>::removeFromCells(const T& value, const glm::vec3& center) {
+    auto removeFromCell = [this, &value](HashGridCell& cell) {
+        for (uint32_t i = 0; i < cell.count; i++) {
+            if (m_objects[cell.start + i].value == value) {
+                m_objects[cell.start + i] = m_objects[cell.start + cell.count - 1];
+                cell.count--;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    int index = findCell(cellCoord(center));
+    if (index >= 0 && removeFromCell(m_cells[index])) {
+        return true;
+    }
+
+    // The object moved since it was inserted, fall back to scanning every cell
+    for (HashGridCell& cell : m_cells) {
+        if (removeFromCell(cell)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename BoundsFn>
+bool SpatialHashGrid<T, BoundsFn>::remove(const T& value, const AABB& insertedBounds) {
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        if (m_pending[i].value == value) {
+            m_pending[i] = m_pending.back();
+            m_pending.pop_back();
+            m_objectCount--;
+            return true;
+        }
+    }
+
+    if (removeFromCells(value, insertedBounds.center())) {
+        m_objectCount--;
+        return true;
+    }
+    return false;
+}
+
+template <typename T, typename BoundsFn>
+bool SpatialHashGrid<T, BoundsFn>::remove(const T& value) {
+    return remove(value, m_boundsFn(value));
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::clear() {
+    m_cells.clear();
+    m_objects.clear();
+    m_table.clear();
+    m_pending.clear();
+    m_tableMask = 0;
+    m_objectCount = 0;
+    m_maxHalfExtent = glm::vec3(0.0f);
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::commit() {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    std::vector<Item> items;
+    items.reserve(m_objectCount);
+    for (const HashGridCell& cell : m_cells) {
+        items.insert(items.end(), m_objects.begin() + cell.start, m_objects.begin() + cell.start + cell.count);
+    }
+    items.insert(items.end(), m_pending.begin(), m_pending.end());
+
+    rebuildItems(items);
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::rebuild(const std::vector<T>& values) {
+    std::vector<Item> items;
+    items.reserve(values.size());
+    for (const T& value : values) {
+        items.push_back({value, m_boundsFn(value)});
+    }
+    rebuildItems(items);
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::rebuildItems(const std::vector<Item>& items) {
+    clear();
+    if (items.empty()) {
+        return;
+    }
+
+    if (!m_fixedCellSize) {
+        m_cellSize = chooseCellSize(items);
+        m_inverseCellSize = 1.0f / m_cellSize;
+    }
+
+    // There are never more cells than objects, so this keeps the load factor at or below 0.5
+    uint32_t tableSize = 16;
+    while (tableSize < items.size() * 2) {
+        tableSize <<= 1;
+    }
+    m_table.assign(tableSize, 0);
+    m_tableMask = tableSize - 1;
+
+    std::vector<uint32_t> itemCells(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        const AABB& bounds = items[i].bounds;
+        m_maxHalfExtent = glm::max(m_maxHalfExtent, bounds.size() * 0.5f);
+
+        uint32_t index = findOrAddCell(cellCoord(bounds.center()));
+        m_cells[index].count++;
+        itemCells[i] = index;
+    }
+
+    // Counting sort the objects so every cell's objects are contiguous
+    uint32_t offset = 0;
+    for (HashGridCell& cell : m_cells) {
+        cell.start = offset;
+        offset += cell.count;
+        cell.count = 0;
+    }
+
+    m_objects.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        HashGridCell& cell = m_cells[itemCells[i]];
+        m_objects[cell.start + cell.count++] = items[i];
+    }
+
+    m_objectCount = (int)items.size();
+}
+
+template <typename T, typename BoundsFn>
+template <typename Fn>
+bool SpatialHashGrid<T, BoundsFn>::visitCells(const glm::ivec3& lo, const glm::ivec3& hi, Fn&& fn) const {
+    // In double, a range over the whole clamped coordinate space is 2^31 + 1 cells per axis
+    double span = ((double)hi.x - (double)lo.x + 1.0) * ((double)hi.y - (double)lo.y + 1.0) *
+                  ((double)hi.z - (double)lo.z + 1.0);
+
+    // Small ranges probe the table per coordinate, big ones are cheaper as a scan of the occupied cells
+    if (span <= (double)m_cells.size()) {
+        for (int x = lo.x; x <= hi.x; x++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int z = lo.z; z <= hi.z; z++) {
+                    int index = findCell(glm::ivec3(x, y, z));
+                    if (index >= 0 && !fn(m_cells[index])) {
+                        return false;
+                    }
+                }
+            }
+        }
+    } else {
+        for (const HashGridCell& cell : m_cells) {
+            if (cell.coord.x >= lo.x && cell.coord.x <= hi.x &&
+                cell.coord.y >= lo.y && cell.coord.y <= hi.y &&
+                cell.coord.z >= lo.z && cell.coord.z <= hi.z &&
+                !fn(cell)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T, typename BoundsFn>
+template <typename F>
+void SpatialHashGrid<T, BoundsFn>::forEachInFrustum(const Frustum& frustum, F&& fn) const {
+    for (const HashGridCell& cell : m_cells) {
+        if (cell.count == 0) {
+            continue;
+        }
+
+        glm::vec3 min, max;
+        cellBounds(cell, min, max);
+        if (!frustum.isAABBVisible(min, max)) {
+            continue;
+        }
+
+        for (uint32_t i = cell.start; i < cell.start + cell.count; i++) {
+            const Item& item = m_objects[i];
+            if (frustum.isAABBVisible(item.bounds) && !invokeVisitor(fn, item.value)) {
+                return;
+            }
+        }
+    }
+
+    for (const Item& item : m_pending) {
+        if (frustum.isAABBVisible(item.bounds) && !invokeVisitor(fn, item.value)) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename BoundsFn>
+template <typename F>
+void SpatialHashGrid<T, BoundsFn>::forEachInRange(const glm::vec3& center, float radius, F&& fn) const {
+    // Objects are bucketed by their center, so only cells touching the sphere can hold a match
+    glm::ivec3 lo = cellCoord(center - glm::vec3(radius));
+    glm::ivec3 hi = cellCoord(center + glm::vec3(radius));
+    float radiusSq = radius * radius;
+
+    auto inRange = [&center, radiusSq](const Item& item) {
+        glm::vec3 d = item.bounds.center() - center;
+        return glm::dot(d, d) <= radiusSq;
+    };
+
+    bool finished = visitCells(lo, hi, [&](const HashGridCell& cell) {
+        for (uint32_t i = cell.start; i < cell.start + cell.count; i++) {
+            if (inRange(m_objects[i]) && !invokeVisitor(fn, m_objects[i].value)) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!finished) {
+        return;
+    }
+
+    for (const Item& item : m_pending) {
+        if (inRange(item) && !invokeVisitor(fn, item.value)) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename BoundsFn>
+template <typename F>
+void SpatialHashGrid<T, BoundsFn>::forEachInAABB(const glm::vec3& min, const glm::vec3& max, F&& fn) const {
+    glm::ivec3 lo = cellCoord(min - m_maxHalfExtent);
+    glm::ivec3 hi = cellCoord(max + m_maxHalfExtent);
+    AABB query(min, max);
+
+    bool finished = visitCells(lo, hi, [&](const HashGridCell& cell) {
+        for (uint32_t i = cell.start; i < cell.start + cell.count; i++) {
+            if (query.overlaps(m_objects[i].bounds) && !invokeVisitor(fn, m_objects[i].value)) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!finished) {
+        return;
+    }
+
+    for (const Item& item : m_pending) {
+        if (query.overlaps(item.bounds) && !invokeVisitor(fn, item.value)) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::queryFrustum(const Frustum& frustum, std::vector<T>& result) const {
+    result.clear();
+    result.reserve(m_objectCount / 4);
+    forEachInFrustum(frustum, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::queryRange(const glm::vec3& center, float radius, std::vector<T>& result) const {
+    result.clear();
+    forEachInRange(center, radius, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn>
+void SpatialHashGrid<T, BoundsFn>::queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<T>& result) const {
+    result.clear();
+    forEachInAABB(min, max, [&result](const T& value) { result.push_back(value); });
+}
+
+template <typename T, typename BoundsFn>
+bool SpatialHashGrid<T, BoundsFn>::raycast(const glm::vec3& origin, const glm::vec3& direction,
+                                           float maxDistance, T* hit) const {
+    glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float closestDist = maxDistance;
+    bool found = false;
+
+    auto testItem = [&](const Item& item) {
+        float t;
+        if (rayHitsAABB(origin, invDir, item.bounds.min, item.bounds.max, closestDist, t) && t < closestDist) {
+            closestDist = t;
+            *hit = item.value;
+            found = true;
+        }
+    };
+
+    for (const HashGridCell& cell : m_cells) {
+        if (cell.count == 0) {
+            continue;
+        }
+
+        glm::vec3 min, max;
+        float t;
+        cellBounds(cell, min, max);
+        if (!rayHitsAABB(origin, invDir, min, max, closestDist, t)) {
+            continue;
+        }
+
+        for (uint32_t i = cell.start; i < cell.start + cell.count; i++) {
+            testItem(m_objects[i]);
+        }
+    }
+
+    for (const Item& item : m_pending) {
+        testItem(item);
+    }
+
+    return found;
+}
+
+// The scene's box index, instantiated once in SpatialHashGrid.cpp
+extern template class SpatialHashGrid<Box*, BoxBounds>;
+using BoxHashGrid = SpatialHashGrid<Box*, BoxBounds>;
@@ -0,0 +1,44 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "AABB.h"
+
+// A payload as stored by the spatial indices, together with the bounds it was inserted with
+template <typename T>
+struct SpatialItem {
+    T value;
+    AABB bounds;
+};
+
+// Calls a spatial query visitor. Visitors either return void, or bool where false stops the query.
+// Returns false when the query should stop.
+template <typename F, typename T>
+inline bool invokeVisitor(F& fn, T&& item) {
+    if constexpr (std::is_same<decltype(fn(std::forward<T>(item))), bool>::value) {
+        return fn(std::forward<T>(item));
+    } else {
+        fn(std::forward<T>(item));
+        return true;
+    }
+}
+
+// Slab test, tHit is the entry distance (0 when the origin is inside)
+inline bool rayHitsAABB(const glm::vec3& origin, const glm::vec3& invDir,
+                        const glm::vec3& min, const glm::vec3& max, float maxDistance, float& tHit) {
+    float t0 = 0.0f;
+    float t1 = maxDistance;
+
+    for (int i = 0; i < 3; i++) {
+        float ta = (min[i] - origin[i]) * invDir[i];
+        float tb = (max[i] - origin[i]) * invDir[i];
+        if (invDir[i] < 0.0f) std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t1 < t0) return false;
+    }
+
+    tHit = t0;
+    return true;
+}
@@ -0,0 +1,300 @@
+#include "WorldStreamer.h"
+#include "Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Entities moved into or out of the scene between two budget checks, sized from the measured
+// cost per entity so a slice fits what is left of the budget
+const size_t kMinSlice = 64;
+const size_t kMaxSlice = 4096;
+
+size_t sliceSize(double remainingMs, double msPerEntity) {
+    double fit = remainingMs / std::max(msPerEntity, 1e-6);
+    return (size_t)std::max((double)kMinSlice, std::min((double)kMaxSlice, fit));
+}
+
+// Cost estimates follow the scene as it grows, one slow slice does not throw them off
+void updateCost(double& msPerEntity, double ms, size_t entities) {
+    if (entities > 0) {
+        msPerEntity = 0.75 * msPerEntity + 0.25 * (ms / entities);
+    }
+}
+
+}
+
+WorldStreamer::WorldStreamer(Scene* scene, float cellSize, const StreamCellLoader& loader, int workerCount)
+    : m_scene(scene), m_cellSize(cellSize > 0.0f ? cellSize : 64.0f), m_loader(loader),
+      m_loadRadius(4.0f * m_cellSize), m_unloadRadius(5.0f * m_cellSize), m_frameBudgetMs(2.0),
+      m_nextRequest(1), m_msPerAdd(0.001), m_msPerRemove(0.001), m_stop(false) {
+    for (int i = 0; i < std::max(1, workerCount); i++) {
+        m_workers.emplace_back(&WorldStreamer::workerLoop, this);
+    }
+}
+
+WorldStreamer::~WorldStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    for (auto& entry : m_cells) {
+        delete entry.second;
+    }
+}
+
+void WorldStreamer::setLoadRadius(float radius) {
+    m_loadRadius = std::max(0.0f, radius);
+    m_unloadRadius = std::max(m_unloadRadius, m_loadRadius);
+}
+
+void WorldStreamer::setUnloadRadius(float radius) {
+    m_unloadRadius = std::max(radius, m_loadRadius);
+}
+
+void WorldStreamer::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        if (m_stop) {
+            return;
+        }
+
+        // Nearest cell first, the main thread keeps the distances current
+        size_t next = 0;
+        for (size_t i = 1; i < m_jobs.size(); i++) {
+            if (m_jobs[i].distance < m_jobs[next].distance) {
+                next = i;
+            }
+        }
+        Job job = m_jobs[next];
+        m_jobs[next] = m_jobs.back();
+        m_jobs.pop_back();
+        lock.unlock();
+
+        Result result;
+        result.key = job.key;
+        result.request = job.request;
+        if (!m_loader(job.x, job.z, m_cellSize, result.data)) {
+            result.data = StreamCellData();
+        }
+
+        lock.lock();
+        m_results.push_back(std::move(result));
+    }
+}
+
+float WorldStreamer::cellDistance(int x, int z, const glm::vec3& center) const {
+    // To the closest point of the cell, so a camera inside a cell is at distance 0
+    float minX = x * m_cellSize;
+    float minZ = z * m_cellSize;
+    float dx = std::max(std::max(minX - center.x, center.x - (minX + m_cellSize)), 0.0f);
+    float dz = std::max(std::max(minZ - center.z, center.z - (minZ + m_cellSize)), 0.0f);
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldStreamer::update(const glm::vec3& center) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&start]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    collectResults();
+    requestCells(center);
+
+    // At least one slice per frame so a tiny budget still makes progress
+    bool first = true;
+    while (!m_unloadQueue.empty() && (first || elapsedMs() < m_frameBudgetMs)) {
+        first = false;
+        auto it = m_cells.find(m_unloadQueue.front());
+        if (unloadSlice(it->second, sliceSize(m_frameBudgetMs - elapsedMs(), m_msPerRemove))) {
+            delete it->second;
+            m_cells.erase(it);
+            m_unloadQueue.pop_front();
+        }
+    }
+
+    while (!m_integrateQueue.empty() && (first || elapsedMs() < m_frameBudgetMs)) {
+        first = false;
+        Cell* cell = m_cells[m_integrateQueue.front()];
+        if (integrateSlice(cell, sliceSize(m_frameBudgetMs - elapsedMs(), m_msPerAdd))) {
+            cell->state = CellState::Loaded;
+            cell->data = StreamCellData();
+            m_integrateQueue.pop_front();
+        }
+    }
+
+    updateStats();
+    m_stats.lastFrameMs = elapsedMs();
+}
+
+void WorldStreamer::collectResults() {
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+    }
+
+    for (Result& result : results) {
+        // Cells that went out of range while loading are gone or were requested again since
+        auto it = m_cells.find(result.key);
+        if (it == m_cells.end() || it->second->request != result.request) {
+            continue;
+        }
+
+        Cell* cell = it->second;
+        size_t count = std::min(result.data.positions.size(), result.data.sizes.size());
+        result.data.positions.resize(count);
+        result.data.sizes.resize(count);
+        cell->data = std::move(result.data);
+        cell->state = CellState::Integrating;
+        cell->entities.reserve(count);
+        m_integrateQueue.push_back(result.key);
+    }
+}
+
+void WorldStreamer::requestCells(const glm::vec3& center) {
+    std::vector<uint64_t> cancelled;
+    for (auto& entry : m_cells) {
+        Cell* cell = entry.second;
+        if (cell->state == CellState::Unloading || cellDistance(cell->x, cell->z, center) <= m_unloadRadius) {
+            continue;
+        }
+
+        if (cell->state == CellState::Loading) {
+            cancelled.push_back(entry.first);
+            continue;
+        }
+        if (cell->state == CellState::Integrating) {
+            m_integrateQueue.erase(std::find(m_integrateQueue.begin(), m_integrateQueue.end(), entry.first));
+            cell->data = StreamCellData();
+        }
+        cell->state = CellState::Unloading;
+        m_unloadQueue.push_back(entry.first);
+    }
+    for (uint64_t key : cancelled) {
+        delete m_cells[key];
+        m_cells.erase(key);
+    }
+
+    std::vector<Job> jobs;
+    int minX = (int)std::floor((center.x - m_loadRadius) / m_cellSize);
+    int maxX = (int)std::floor((center.x + m_loadRadius) / m_cellSize);
+    int minZ = (int)std::floor((center.z - m_loadRadius) / m_cellSize);
+    int maxZ = (int)std::floor((center.z + m_loadRadius) / m_cellSize);
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            uint64_t key = cellKey(x, z);
+            float distance = cellDistance(x, z, center);
+            if (distance > m_loadRadius || m_cells.count(key)) {
+                continue;
+            }
+
+            Cell* cell = new Cell();
+            cell->x = x;
+            cell->z = z;
+            cell->state = CellState::Loading;
+            cell->request = m_nextRequest++;
+            m_cells[key] = cell;
+            jobs.push_back({key, cell->request, x, z, distance});
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_jobs.size();) {
+        Job& job = m_jobs[i];
+        auto it = m_cells.find(job.key);
+        if (it == m_cells.end() || it->second->request != job.request) {
+            job = m_jobs.back();
+            m_jobs.pop_back();
+            continue;
+        }
+        job.distance = cellDistance(job.x, job.z, center);
+        i++;
+    }
+    m_jobs.insert(m_jobs.end(), jobs.begin(), jobs.end());
+    if (!jobs.empty()) {
+        m_wake.notify_all();
+    }
+}
+
+bool WorldStreamer::integrateSlice(Cell* cell, size_t maxEntities) {
+    size_t count = cell->data.positions.size();
+    size_t end = std::min(count, cell->integrated + maxEntities);
+    if (cell->integrated < end) {
+        auto start = std::chrono::steady_clock::now();
+        m_slicePositions.assign(cell->data.positions.begin() + cell->integrated, cell->data.positions.begin() + end);
+        m_sliceSizes.assign(cell->data.sizes.begin() + cell->integrated, cell->data.sizes.begin() + end);
+        m_scene->createRects(m_slicePositions, m_sliceSizes, &cell->entities, cell->data.isStatic);
+        updateCost(m_msPerAdd, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                   end - cell->integrated);
+        cell->integrated = end;
+    }
+    return cell->integrated == count;
+}
+
+bool WorldStreamer::unloadSlice(Cell* cell, size_t maxEntities) {
+    auto start = std::chrono::steady_clock::now();
+    size_t end = cell->entities.size() > maxEntities ? cell->entities.size() - maxEntities : 0;
+    for (size_t i = cell->entities.size(); i > end; i--) {
+        m_scene->removeEntity(cell->entities[i - 1]);
+    }
+    updateCost(m_msPerRemove, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+               cell->entities.size() - end);
+    cell->entities.resize(end);
+    return cell->entities.empty();
+}
+
+void WorldStreamer::unloadAll() {
+    for (auto& entry : m_cells) {
+        for (EntityHandle entity : entry.second->entities) {
+            m_scene->removeEntity(entity);
+        }
+    }
+    reset();
+}
+
+void WorldStreamer::reset() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.clear();
+    }
+    for (auto& entry : m_cells) {
+        delete entry.second;
+    }
+    m_cells.clear();
+    m_integrateQueue.clear();
+    m_unloadQueue.clear();
+    updateStats();
+}
+
+bool WorldStreamer::isIdle() const {
+    for (const auto& entry : m_cells) {
+        if (entry.second->state != CellState::Loaded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void WorldStreamer::updateStats() {
+    m_stats.loadedCells = 0;
+    m_stats.loadingCells = 0;
+    m_stats.integratingCells = 0;
+    m_stats.unloadingCells = 0;
+    for (const auto& entry : m_cells) {
+        switch (entry.second->state) {
+            case CellState::Loading:     m_stats.loadingCells++; break;
+            case CellState::Integrating: m_stats.integratingCells++; break;
+            case CellState::Loaded:      m_stats.loadedCells++; break;
+            case CellState::Unloading:   m_stats.unloadingCells++; break;
+        }
+    }
+}
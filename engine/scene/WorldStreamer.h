@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "EntityStorage.h"
+
+class Scene;
+
+// What a loader hands back for one cell
+struct StreamCellData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> sizes;
+    bool isStatic = true;
+};
+
+// Fills data for the cell at (x, z), cell (0, 0) covers [0, cellSize) on both axes. Runs on a
+// worker thread, so it must not touch the scene. Returning false leaves the cell empty.
+using StreamCellLoader = std::function<bool(int x, int z, float cellSize, StreamCellData& data)>;
+
+struct StreamingStats {
+    int loadedCells = 0;      // fully in the scene
+    int loadingCells = 0;     // queued or on a worker
+    int integratingCells = 0; // loaded, waiting for or going into the scene
+    int unloadingCells = 0;
+    double lastFrameMs = 0.0; // main thread time of the last update
+};
+
+// Loads and unloads square cells of the world on the x/z plane around a point, usually the camera.
+// Loaders run on background threads, the main thread then moves finished cells into the scene a
+// slice at a time and stops for the frame once the time budget is used up, so big cells spread
+// over several frames instead of causing a spike. Unloading goes through the same budget.
+class WorldStreamer {
+public:
+    WorldStreamer(Scene* scene, float cellSize, const StreamCellLoader& loader, int workerCount = 1);
+    ~WorldStreamer();
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    // Cells closer than the load radius are loaded, cells past the unload radius go away again.
+    // The unload radius is kept at least as large as the load radius.
+    void setLoadRadius(float radius);
+    void setUnloadRadius(float radius);
+    void setFrameBudget(double ms) { m_frameBudgetMs = ms; }
+
+    float getCellSize() const { return m_cellSize; }
+    float getLoadRadius() const { return m_loadRadius; }
+    float getUnloadRadius() const { return m_unloadRadius; }
+    double getFrameBudget() const { return m_frameBudgetMs; }
+
+    // Called once per frame by the scene
+    void update(const glm::vec3& center);
+    // Removes everything that was streamed in from the scene right away, ignoring the budget
+    void unloadAll();
+    // Forgets every cell without touching the scene, for when the scene was cleared
+    void reset();
+    // True while cells are waiting to go into or out of the scene
+    bool isIntegrating() const { return !m_integrateQueue.empty() || !m_unloadQueue.empty(); }
+    bool isIdle() const;
+
+    const StreamingStats& getStats() const { return m_stats; }
+
+private:
+    enum class CellState {
+        Loading,
+        Integrating,
+        Loaded,
+        Unloading
+    };
+
+    struct Cell {
+        int x, z;
+        CellState state;
+        uint64_t request;
+        StreamCellData data;
+        size_t integrated = 0; // rows of data already in the scene
+        std::vector<EntityHandle> entities;
+    };
+
+    struct Job {
+        uint64_t key;
+        uint64_t request;
+        int x, z;
+        float distance;
+    };
+
+    struct Result {
+        uint64_t key;
+        uint64_t request;
+        StreamCellData data;
+    };
+
+    static uint64_t cellKey(int x, int z) { return (uint64_t)(uint32_t)x << 32 | (uint32_t)z; }
+
+    Scene* m_scene;
+    float m_cellSize;
+    StreamCellLoader m_loader;
+    float m_loadRadius;
+    float m_unloadRadius;
+    double m_frameBudgetMs;
+    uint64_t m_nextRequest;
+    double m_msPerAdd;
+    double m_msPerRemove;
+
+    // Main thread only
+    std::unordered_map<uint64_t, Cell*> m_cells;
+    std::deque<uint64_t> m_integrateQueue;
+    std::deque<uint64_t> m_unloadQueue;
+    std::vector<glm::vec3> m_slicePositions;
+    std::vector<glm::vec3> m_sliceSizes;
+    StreamingStats m_stats;
+
+    // Shared with the workers
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Job> m_jobs;
+    std::vector<Result> m_results;
+    bool m_stop;
+    std::vector<std::thread> m_workers;
+
+    void workerLoop();
+    float cellDistance(int x, int z, const glm::vec3& center) const;
+    void collectResults();
+    void requestCells(const glm::vec3& center);
+    bool integrateSlice(Cell* cell, size_t maxEntities);
+    bool unloadSlice(Cell* cell, size_t maxEntities);
+    void updateStats();
+};
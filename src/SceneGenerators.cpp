@@ -0,0 +1,53 @@
+#include "SceneGenerators.h"
+#include <random>
+
+BoxMergeStats createTerrainGrid(Scene* scene, int size, float spacing, bool merge) {
+    // we fill a list of positions and sizes first and hand them to the scene in one go,
+    // that is way faster than calling createRect for every block once you have thousands of them.
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> sizes;
+    // blocks normally leave a small gap so you can tell them apart, merging needs them touching
+    float blockSize = merge ? spacing : spacing * 0.9f;
+
+    for (int x = -size; x <= size; x++) {
+        for (int z = -size; z <= size; z++) {
+
+            // for a single object you can just call createRect on the scene, like this:
+            // myScene->createRect(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+            // if you want to hard code in vaules make sure its a float so "1.0f"
+            positions.push_back(glm::vec3(x * spacing, -2.0f, z * spacing));
+            sizes.push_back(glm::vec3(blockSize, 0.5f, blockSize));
+        }
+    }
+
+    // static boxes that touch can be fused into bigger ones before they go in to the scene,
+    // a flat floor of touching blocks ends up as very few boxes.
+    BoxMergeStats stats;
+    if (merge) {
+        stats = mergeBoxes(positions, sizes);
+    }
+
+    // the floor never moves so we make it static (the last true), the scene bakes static stuff
+    // into big chunks and draws a whole chunk at once instead of every block on its own.
+    scene->createRects(positions, sizes, nullptr, true);
+    return stats;
+}
+
+void createRandomObjects(Scene* scene, int count, float rangeMin, float rangeMax) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> posDist(rangeMin, rangeMax);
+    std::uniform_real_distribution<float> yDist(0.0f, 15.0f);
+    std::uniform_real_distribution<float> sizeDist(0.5f, 2.5f);
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> sizes;
+    positions.reserve(count);
+    sizes.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        positions.push_back(glm::vec3(posDist(rng), yDist(rng), posDist(rng)));
+        sizes.push_back(glm::vec3(sizeDist(rng)));
+    }
+
+    scene->createRects(positions, sizes);
+}
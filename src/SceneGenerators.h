@@ -0,0 +1,11 @@
+#pragma once
+#include "../engine/scene/Scene.h"
+#include "../engine/scene/BoxMerge.h"
+
+// these 2 are just to generate objects in to the scenes, engine_bench builds its scenes with them too.
+
+// a flat static floor of (size * 2 + 1)^2 blocks, spacing apart. with merge the blocks have no gap
+// between them and are fused before they go in to the scene, the stats say how much that saved.
+BoxMergeStats createTerrainGrid(Scene* scene, int size, float spacing, bool merge = false);
+// count moving boxes spread between rangeMin and rangeMax on x and z, always the same ones
+void createRandomObjects(Scene* scene, int count, float rangeMin, float rangeMax);
@@ -2,7 +2,11 @@
 #include "../engine/core/InputManager.h"
 #include "../engine/components/FlyCamera.h"
 #include "../engine/core/Engine.h"
+#include "SceneGenerators.h"
 #include <random>
+#include <cmath>
+#include <iostream>
+#include <cstring>
 
 /*
  * This is an example file to showcase how to use different engine tools.
@@ -10,43 +14,80 @@
  */
 
 
-// these 2 are just to generate objects in to the scenes
-void createTerrainGrid(Scene* scene, int size, float spacing) {
-    for (int x = -size; x <= size; x++) {
-        for (int z = -size; z <= size; z++) {
-
-            // this is the actuall logic. you chose a scene in this case scene is a var you can just "myScene->"
-            // then you chose the function in this case createRect();
-            // then inside you create 2 vec3's one for pos and one for size if you want to hard code in vaules make sure its a float so "1.0f", so a use of this can be:
-            // myScene->createRect(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
-            scene->createRect(
-                glm::vec3(x * spacing, -2.0f, z * spacing),
-                glm::vec3(spacing * 0.9f, 0.5f, spacing * 0.9f)
-            );
+// big ground is better done as a terrain than as boxes, this one is just some rolling hills.
+void createHills(Scene* scene, int size, float spacing) {
+    // the terrain is centered on 0,0 and sits a bit below the camera
+    float half = size * spacing * 0.5f;
+    Terrain* terrain = scene->createTerrain(size, spacing, glm::vec3(-half, -10.0f, -half));
+
+    int samples = terrain->getSamplesPerSide();
+    for (int z = 0; z < samples; z++) {
+        for (int x = 0; x < samples; x++) {
+            float fx = x * spacing;
+            float fz = z * spacing;
+            float height = std::sin(fx * 0.02f) * std::cos(fz * 0.02f) * 12.0f
+                         + std::sin(fx * 0.11f + fz * 0.07f) * 2.0f;
+            terrain->setHeight(x, z, height);
         }
     }
 }
 
-void createRandomObjects(Scene* scene, int count, float rangeMin, float rangeMax) {
-    std::mt19937 rng(42);
-    std::uniform_real_distribution<float> posDist(rangeMin, rangeMax);
-    std::uniform_real_distribution<float> yDist(0.0f, 15.0f);
-    std::uniform_real_distribution<float> sizeDist(0.5f, 2.5f);
-
-    for (int i = 0; i < count; i++) {
-        scene->createRect(
-            glm::vec3(posDist(rng), yDist(rng), posDist(rng)),
-            sizeDist(rng)
-        );
-    }
-}
-
 
+// the rocks on the hills are streamed in around the camera instead of all being made up front.
+// the loader runs on a background thread, it only reads the terrain which is done changing by now.
+void addStreamedRocks(Scene* scene) {
+    const Terrain* terrain = scene->getTerrain();
+    WorldStreamer* streamer = scene->createStreamer(64.0f, [terrain](int x, int z, float cellSize, StreamCellData& data) {
+        // seeding with the cell means a cell gets the same rocks every time it comes back
+        std::mt19937 rng((uint32_t)(x * 73856093) ^ (uint32_t)(z * 19349663));
+        std::uniform_real_distribution<float> offset(0.0f, cellSize);
+        std::uniform_real_distribution<float> sizeDist(0.3f, 1.5f);
+
+        for (int i = 0; i < 200; i++) {
+            float wx = x * cellSize + offset(rng);
+            float wz = z * cellSize + offset(rng);
+            float size = sizeDist(rng);
+            data.positions.push_back(glm::vec3(wx, terrain->heightAt(wx, wz) + size * 0.5f, wz));
+            data.sizes.push_back(glm::vec3(size));
+        }
+        data.isStatic = true;
+        return true;
+    });
+    streamer->setLoadRadius(200.0f);
+    streamer->setUnloadRadius(260.0f);
+}
 
+int main(int argc, char** argv) {
+    // command line flags for perf testing:
+    //   --record file    saves the camera path you fly to file when the window closes
+    //   --replay file    flies that path again with vsync off and prints the frame times
+    //   --profile file   prints the frame times and also saves them per frame to file as csv
+    //   --no-vsync       draws as fast as it can
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
+    const char* profileFile = nullptr;
+    bool vsync = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profileFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-vsync") == 0) {
+            vsync = false;
+        } else {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return -1;
+        }
+    }
 
-int main() {
     // this explains its self mostly, its the window size and text.
     Application app(1920, 1080, "3D Engine");
+    // without a display the window can't open, the reason is printed so we just stop here.
+    if (!app.isInitialized()) {
+        return -1;
+    }
 
     // Setup input
     // here we init the input manager.
@@ -64,7 +105,7 @@ int main() {
 
     FlyCamera camera(&input);
     camera.setPosition({0, 10, 30});
-    camera.setSpeed(0.5f);
+    camera.setSpeed(30.0f);
     camera.setSensitivity(0.1f);
 
     app.setInputManager(&input);
@@ -93,19 +134,70 @@ int main() {
     Scene* testScene = Engine::createScene("main");
 
     // here we use the fuction from earlyer to create a grid of blocks.
-    createTerrainGrid(testScene, 20, 5.0f);
+    // the blocks are static, so they go in the static octree and get baked into chunks. the
+    // spatial index (octree or hash grid, see setSpatialIndex) is only for moving entities.
+    // the last true fuses the floor blocks into bigger boxes first, here is what that saved.
+    BoxMergeStats merge = createTerrainGrid(testScene, 20, 5.0f, true);
+    std::cout << "Terrain merge: " << merge.boxesBefore << " -> " << merge.boxesAfter << " boxes, "
+              << merge.trianglesBefore << " -> " << merge.trianglesAfter << " triangles, "
+              << merge.drawsBefore << " -> " << merge.drawsAfter << " draws" << std::endl;
 
     // create another scene with wayyy more objects to test renderer preformace.
-    Scene* perfTest = Engine::createScene("performance");
-    createRandomObjects(perfTest, 10000, -25.0f, 25.0f);
+    // this one and the terrain below are made on a background thread, so the window opens right
+    // away and the scenes show up when they are done. pressing 3 before that switches once it's ready.
+    Engine::createSceneAsync("performance", [](Scene* perfTest) {
+        // this scene never changes after load, so we let the octree pack itself into its compressed form.
+        perfTest->getOctree()->setCompressed(true);
+        // the first run saves the scene to a file, later runs just load that file which skips
+        // generating the objects and building the octree. delete the file to get new objects.
+        if (!perfTest->loadFromFile("performance.scene")) {
+            createRandomObjects(perfTest, 10000, -25.0f, 25.0f);
+            perfTest->saveToFile("performance.scene");
+        }
+    });
+
+
+    // a terrain scene, press 2 to see it. 1024 x 1024 cells but only the chunks near the camera
+    // are drawn in full detail, far away ones use less and the ones behind you are skipped.
+    Engine::createSceneAsync("test", [](Scene* terrainScene) {
+        createHills(terrainScene, 1024, 1.0f);
+        addStreamedRocks(terrainScene);
+    });
 
 
     // setActiveScene is used to chose scene it can be used like this or at runtime to change our scene.
     Engine::setActiveScene("main");
 
 
+    // recording just saves where the camera was every frame.
+    CameraPath recorded;
+    if (recordFile) {
+        app.recordCameraPath(&recorded);
+    }
+
+    // a replay has to wait for the scenes, or the first frames would time the loading.
+    // vsync would cap every frame at the monitor rate, so it's off to see the real times.
+    CameraPath replay;
+    if (replayFile) {
+        if (!replay.loadFromFile(replayFile)) {
+            return -1;
+        }
+        app.waitForLoadingScenes();
+        app.replayCameraPath(&replay);
+        vsync = false;
+    }
+    app.setVsync(vsync);
+    app.enableFrameProfiling(replayFile || profileFile);
+
     // start the app
     app.run();
 
+    if (recordFile) {
+        recorded.saveToFile(recordFile);
+    }
+    if (profileFile) {
+        app.getFrameProfiler().writeCsv(profileFile);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "scene/EntityStorage.h"
+#include "TestCheck.h"
+#include <vector>
+
+// Loading replaces whatever the storage held, slots and free list included
+
+int main() {
+    EntityStorage storage;
+    std::vector<EntityHandle> old;
+    for (int i = 0; i < 100; i++) {
+        old.push_back(storage.create(glm::vec3((float)i), glm::vec3(1.0f)));
+    }
+
+    glm::vec3 positions[2] = {glm::vec3(1.0f), glm::vec3(2.0f)};
+    glm::vec3 sizes[2] = {glm::vec3(1.0f), glm::vec3(1.0f)};
+    uint8_t statics[2] = {0, 1};
+    uint32_t rowSlots[2] = {1, 0};
+    uint32_t generations[3] = {4, 7, 2};
+    check(storage.load(positions, sizes, statics, rowSlots, 2, generations, 3), "load over a populated storage");
+    check(storage.size() == 2 && storage.slotCount() == 3, "only the loaded rows and slots are left");
+    check(storage.isAlive(EntityHandle(1, 7)) && storage.indexOf(EntityHandle(0, 4)) == 1, "loaded handles map to their rows");
+    check(!storage.isAlive(old[50]) && !storage.isAlive(old[99]), "handles past the loaded slots are stale");
+
+    EntityHandle created = storage.create(glm::vec3(3.0f), glm::vec3(1.0f));
+    check(created.index == 2 && created.generation == 2 && storage.slotCount() == 3, "create reuses the free loaded slot");
+    EntityHandle grown = storage.create(glm::vec3(4.0f), glm::vec3(1.0f));
+    check(grown.index == 3 && storage.slotCount() == 4 && storage.size() == 4, "then grows the slot table");
+
+    // A broken file leaves an empty storage that still hands out slots from 0
+    uint32_t badGenerations[3] = {4, 0, 2};
+    check(!storage.load(positions, sizes, statics, rowSlots, 2, badGenerations, 3), "zero generation is rejected");
+    check(storage.size() == 0 && storage.slotCount() == 0, "failed load leaves nothing behind");
+    check(storage.create(glm::vec3(0.0f), glm::vec3(1.0f)).index == 0, "create after a failed load starts at slot 0");
+
+    return testResult();
+}
@@ -0,0 +1,59 @@
+#include "scene/Octree.h"
+#include "TestCheck.h"
+#include <vector>
+
+// The packed bounds of every object have to contain its real bounds, otherwise compressed
+// queries drop it. Objects the root could not grow to reach are the hard case.
+
+namespace {
+
+template <typename Bounds>
+bool packedBoundsContainObjects(const BoxOctree& tree, const std::vector<Bounds>& bounds) {
+    const std::vector<PackedOctreeNode>& nodes = tree.getPackedNodes();
+    const std::vector<Box*>& objects = tree.getPackedObjects();
+    for (const PackedOctreeNode& node : nodes) {
+        for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+            glm::vec3 min, max;
+            dequantizeBounds(node, bounds[i], min, max);
+            AABB real = BoxBounds()(objects[i]);
+            for (int axis = 0; axis < 3; axis++) {
+                if (min[axis] > real.min[axis] || max[axis] < real.max[axis]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+int main() {
+    std::vector<Box> boxes;
+    for (int i = 0; i < 500; i++) {
+        boxes.push_back(Box(glm::vec3((i % 10) * 3.0f, (i / 100) * 3.0f, ((i / 10) % 10) * 3.0f), glm::vec3(1.5f)));
+    }
+    // Past the 32 root doublings, these stay at the root
+    boxes.push_back(Box(glm::vec3(1e13f, 0.0f, 0.0f), glm::vec3(1e9f)));
+    boxes.push_back(Box(glm::vec3(-3e12f, 5e12f, 0.0f), glm::vec3(4.0f)));
+
+    for (int precision = 0; precision < 2; precision++) {
+        bool bits8 = precision == 0;
+        BoxOctree tree;
+        tree.setCompressed(true, bits8 ? OctreeBoundsPrecision::Bits8 : OctreeBoundsPrecision::Bits16);
+        for (Box& box : boxes) {
+            tree.insert(&box);
+        }
+        tree.compact();
+        bool contained = bits8 ? packedBoundsContainObjects(tree, tree.getPackedBounds8())
+                               : packedBoundsContainObjects(tree, tree.getPackedBounds16());
+        check(contained, bits8 ? "8 bit packed bounds contain every object"
+                               : "16 bit packed bounds contain every object");
+
+        std::vector<Box*> found;
+        tree.queryAABB(glm::vec3(-1e14f), glm::vec3(1e14f), found);
+        check(found.size() == boxes.size(), "AABB query over everything finds every object");
+    }
+
+    return testResult();
+}
@@ -0,0 +1,61 @@
+#include "scene/Octree.h"
+#include "TestCheck.h"
+#include <vector>
+
+// Packed trees come from .scene files, so loadCompact() has to turn down anything that is not
+// the tree compact() writes. Returns non zero when a check fails.
+
+namespace {
+
+PackedOctreeNode makeNode(uint32_t firstChild, uint32_t childCount) {
+    return {glm::vec3(0.0f), 100.0f, firstChild, childCount, 0, 0};
+}
+
+bool load(const std::vector<PackedOctreeNode>& nodes) {
+    BoxOctree tree;
+    return tree.loadCompact(nodes.data(), nodes.size(), nullptr, 0, (const QuantizedBounds16*)nullptr);
+}
+
+}
+
+int main() {
+    // What compact() writes loads back
+    std::vector<Box> boxes;
+    for (int i = 0; i < 2000; i++) {
+        boxes.push_back(Box(glm::vec3((i % 20) * 4.0f, (i / 400) * 4.0f, ((i / 20) % 20) * 4.0f), glm::vec3(1.0f)));
+    }
+    BoxOctree tree;
+    tree.setCompressed(true);
+    for (Box& box : boxes) {
+        tree.insert(&box);
+    }
+    tree.compact();
+    BoxOctree loaded;
+    check(loaded.loadCompact(tree.getPackedNodes().data(), tree.getPackedNodes().size(),
+                             tree.getPackedObjects().data(), tree.getPackedObjects().size(),
+                             tree.getPackedBounds16().data()) && loaded.getObjectCount() == (int)boxes.size(),
+          "compacted tree loads back");
+
+    // Node 2 is a child of both the root and node 1
+    std::vector<PackedOctreeNode> shared = {makeNode(1, 2), makeNode(2, 1), makeNode(0, 0)};
+    check(!load(shared), "shared child is rejected");
+
+    // A chain of kMaxHeight + 4 odd nodes, where every even node is an unclaimed parent that
+    // also lists the next chain node, so the chain looked one level deep
+    const int chain = BoxOctree::kMaxHeight + 4;
+    std::vector<PackedOctreeNode> deep = {makeNode(1, 1)};
+    for (int i = 1; i < 2 * chain; i++) {
+        bool last = i == 2 * chain - 1;
+        deep.push_back(last ? makeNode(0, 0) : makeNode(i % 2 ? i + 2 : i + 1, 1));
+    }
+    check(!load(deep), "chain deeper than kMaxHeight is rejected");
+
+    // Plain chain past the height limit, every node claimed once
+    std::vector<PackedOctreeNode> tall;
+    for (int i = 0; i <= BoxOctree::kMaxHeight; i++) {
+        tall.push_back(i == BoxOctree::kMaxHeight ? makeNode(0, 0) : makeNode(i + 1, 1));
+    }
+    check(!load(tall), "tree taller than kMaxHeight is rejected");
+
+    return testResult();
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdio>
+
+// Prints one line per check, a test returns testResult() from main
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(bool ok, const char* what) {
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok) {
+        testFailures()++;
+    }
+}
+
+inline int testResult() {
+    return testFailures() == 0 ? 0 : 1;
+}